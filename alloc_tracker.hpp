@@ -0,0 +1,276 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <ostream>
+
+// Opt-in allocation tracking for benchmarks and tests.
+//
+// Build with -DALLOC_TRACKING to replace the global operator new/delete in the
+// including program. Each thread then counts its allocations, bytes and
+// calling sites, and NoAllocationScope turns any allocation on a hot path into
+// a hard failure. Without the flag every type here is an empty no-op, so the
+// guards can stay in production code.
+//
+// The replacement operators are defined in this header, so include it from
+// exactly one translation unit per program when ALLOC_TRACKING is on.
+
+namespace alloc_tracking {
+
+// One allocating call site (return address of the caller of operator new)
+struct AllocationSite {
+    const void* site;
+    std::uint64_t count;
+    std::uint64_t bytes;
+};
+
+// Per-thread counters; plain data so touching them never allocates
+struct ThreadAllocStats {
+    static constexpr std::size_t MAX_SITES = 256;
+
+    std::uint64_t allocations;
+    std::uint64_t deallocations;
+    std::uint64_t bytes;
+    std::uint64_t violations;   // Allocations made inside a NoAllocationScope
+    std::uint32_t guardDepth;   // Nesting depth of active NoAllocationScopes
+    std::uint32_t droppedSites; // Sites that did not fit in the table
+    AllocationSite sites[MAX_SITES];
+};
+
+// Called on an allocation inside a NoAllocationScope; must not allocate
+using ViolationHandler = void (*)(std::size_t bytes, const void* site);
+
+#ifdef ALLOC_TRACKING
+
+inline constexpr bool enabled = true;
+
+inline ThreadAllocStats& thread_stats() {
+    static thread_local ThreadAllocStats stats{};
+    return stats;
+}
+
+inline void default_violation_handler(std::size_t bytes, const void* site) {
+    std::fprintf(stderr, "alloc_tracking: %zu byte allocation from %p inside NoAllocationScope\n",
+                 bytes, site);
+    std::abort();
+}
+
+inline ViolationHandler& violation_handler() {
+    static ViolationHandler handler = &default_violation_handler;
+    return handler;
+}
+
+// Replace the violation handler (e.g. to count instead of abort in a test)
+inline void set_violation_handler(ViolationHandler handler) {
+    violation_handler() = handler ? handler : &default_violation_handler;
+}
+
+namespace detail {
+
+inline void record_allocation(std::size_t bytes, const void* site) {
+    ThreadAllocStats& stats = thread_stats();
+    stats.allocations++;
+    stats.bytes += bytes;
+
+    // Open-addressed site table keyed by return address
+    std::size_t slot = (reinterpret_cast<std::uintptr_t>(site) >> 4) % ThreadAllocStats::MAX_SITES;
+    for (std::size_t probe = 0; probe < ThreadAllocStats::MAX_SITES; ++probe) {
+        AllocationSite& entry = stats.sites[(slot + probe) % ThreadAllocStats::MAX_SITES];
+        if (entry.site == site || entry.site == nullptr) {
+            entry.site = site;
+            entry.count++;
+            entry.bytes += bytes;
+            break;
+        }
+        if (probe + 1 == ThreadAllocStats::MAX_SITES) {
+            stats.droppedSites++;
+        }
+    }
+
+    if (stats.guardDepth > 0) {
+        stats.violations++;
+        violation_handler()(bytes, site);
+    }
+}
+
+inline void* allocate(std::size_t bytes, std::size_t alignment, const void* site) {
+    record_allocation(bytes, site);
+    if (bytes == 0) {
+        bytes = 1;
+    }
+    if (alignment <= alignof(std::max_align_t)) {
+        return std::malloc(bytes);
+    }
+    // aligned_alloc requires the size to be a multiple of the alignment
+    return std::aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment);
+}
+
+// Kept out of line so the compiler does not pair the inlined free() with the
+// replaced operator new and warn about a mismatched deallocation
+[[gnu::noinline]] inline void deallocate(void* ptr) {
+    if (ptr) {
+        thread_stats().deallocations++;
+        std::free(ptr);
+    }
+}
+
+} // namespace detail
+
+#else
+
+inline constexpr bool enabled = false;
+
+inline ThreadAllocStats& thread_stats() {
+    static thread_local ThreadAllocStats stats{};
+    return stats;
+}
+
+inline void set_violation_handler(ViolationHandler) {}
+
+#endif
+
+// Fails (via the violation handler) if this thread allocates while in scope
+class NoAllocationScope {
+public:
+    NoAllocationScope() {
+        if constexpr (enabled) {
+            thread_stats().guardDepth++;
+        }
+    }
+
+    ~NoAllocationScope() {
+        if constexpr (enabled) {
+            thread_stats().guardDepth--;
+        }
+    }
+
+    NoAllocationScope(const NoAllocationScope&) = delete;
+    NoAllocationScope& operator=(const NoAllocationScope&) = delete;
+};
+
+// Measures allocations made by this thread during its lifetime
+class AllocationCounter {
+private:
+    std::uint64_t startAllocations_;
+    std::uint64_t startBytes_;
+
+public:
+    AllocationCounter()
+        : startAllocations_(thread_stats().allocations), startBytes_(thread_stats().bytes) {}
+
+    std::uint64_t allocations() const {
+        return thread_stats().allocations - startAllocations_;
+    }
+
+    std::uint64_t bytes() const {
+        return thread_stats().bytes - startBytes_;
+    }
+};
+
+// Dump this thread's counters and busiest call sites
+inline void print_thread_report(std::ostream& os, std::size_t maxSites = 10) {
+    const ThreadAllocStats& stats = thread_stats();
+    if (!enabled) {
+        os << "alloc_tracking: disabled (build with -DALLOC_TRACKING)\n";
+        return;
+    }
+    os << "alloc_tracking: " << stats.allocations << " allocations, " << stats.bytes
+       << " bytes, " << stats.deallocations << " deallocations, " << stats.violations
+       << " violations\n";
+
+    // Selection of the busiest sites without allocating a sorted copy
+    std::uint64_t lastCount = UINT64_MAX;
+    const void* lastSite = nullptr;
+    for (std::size_t printed = 0; printed < maxSites; ++printed) {
+        const AllocationSite* best = nullptr;
+        for (const AllocationSite& entry : stats.sites) {
+            if (entry.site == nullptr) {
+                continue;
+            }
+            bool belowLast = entry.count < lastCount ||
+                             (entry.count == lastCount && entry.site > lastSite);
+            bool aboveBest = !best || entry.count > best->count ||
+                             (entry.count == best->count && entry.site < best->site);
+            if (belowLast && aboveBest) {
+                best = &entry;
+            }
+        }
+        if (!best) {
+            break;
+        }
+        os << "  site " << best->site << ": " << best->count << " allocations, "
+           << best->bytes << " bytes\n";
+        lastCount = best->count;
+        lastSite = best->site;
+    }
+}
+
+} // namespace alloc_tracking
+
+#ifdef ALLOC_TRACKING
+
+#define ALLOC_TRACKING_CALLER __builtin_return_address(0)
+
+void* operator new(std::size_t bytes) {
+    if (void* p = alloc_tracking::detail::allocate(bytes, 0, ALLOC_TRACKING_CALLER)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t bytes) {
+    if (void* p = alloc_tracking::detail::allocate(bytes, 0, ALLOC_TRACKING_CALLER)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t bytes, std::align_val_t alignment) {
+    if (void* p = alloc_tracking::detail::allocate(bytes, static_cast<std::size_t>(alignment),
+                                                   ALLOC_TRACKING_CALLER)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t bytes, std::align_val_t alignment) {
+    if (void* p = alloc_tracking::detail::allocate(bytes, static_cast<std::size_t>(alignment),
+                                                   ALLOC_TRACKING_CALLER)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t bytes, const std::nothrow_t&) noexcept {
+    return alloc_tracking::detail::allocate(bytes, 0, ALLOC_TRACKING_CALLER);
+}
+
+void* operator new[](std::size_t bytes, const std::nothrow_t&) noexcept {
+    return alloc_tracking::detail::allocate(bytes, 0, ALLOC_TRACKING_CALLER);
+}
+
+void operator delete(void* ptr) noexcept { alloc_tracking::detail::deallocate(ptr); }
+void operator delete[](void* ptr) noexcept { alloc_tracking::detail::deallocate(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { alloc_tracking::detail::deallocate(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { alloc_tracking::detail::deallocate(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { alloc_tracking::detail::deallocate(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { alloc_tracking::detail::deallocate(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    alloc_tracking::detail::deallocate(ptr);
+}
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+    alloc_tracking::detail::deallocate(ptr);
+}
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    alloc_tracking::detail::deallocate(ptr);
+}
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    alloc_tracking::detail::deallocate(ptr);
+}
+
+#undef ALLOC_TRACKING_CALLER
+
+#endif
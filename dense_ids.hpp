@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// Maps sparse 64-bit external IDs to dense 32-bit indices assigned in registration order.
+// Indices are never reused, so they can key plain arrays and bitsets; the external ID is
+// needed only where a request enters or a response leaves.
+class DenseIdMap {
+private:
+    std::unordered_map<uint64_t, uint32_t> toDense_;
+    std::vector<uint64_t> toExternal_;
+
+public:
+    // Index of the ID, assigning the next one on first sight
+    uint32_t intern(uint64_t externalId) {
+        auto [it, inserted] = toDense_.try_emplace(externalId, static_cast<uint32_t>(toExternal_.size()));
+        if (inserted) {
+            toExternal_.push_back(externalId);
+        }
+        return it->second;
+    }
+
+    std::optional<uint32_t> find(uint64_t externalId) const {
+        auto it = toDense_.find(externalId);
+        if (it == toDense_.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    uint64_t external(uint32_t index) const { return toExternal_[index]; }
+
+    std::size_t size() const { return toExternal_.size(); }
+};
+
+// Growable bitset over dense indices; bits past the end read as clear
+class DenseBitset {
+private:
+    std::vector<uint64_t> words_;
+
+public:
+    void set(uint32_t index) {
+        if ((index >> 6) >= words_.size()) {
+            words_.resize((index >> 6) + 1);
+        }
+        words_[index >> 6] |= uint64_t{1} << (index & 63);
+    }
+
+    void reset(uint32_t index) {
+        if ((index >> 6) < words_.size()) {
+            words_[index >> 6] &= ~(uint64_t{1} << (index & 63));
+        }
+    }
+
+    bool test(uint32_t index) const {
+        return (index >> 6) < words_.size() && ((words_[index >> 6] >> (index & 63)) & 1);
+    }
+};
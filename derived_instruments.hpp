@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// One input of a derived instrument: weight * leg
+struct DerivedLeg {
+    uint64_t instrumentId;
+    double weight;
+};
+
+// A leg resolved to the publisher's dense instrument index
+struct IndexedLeg {
+    uint32_t instrument;
+    double weight;
+};
+
+// Linear derived instruments (spreads, baskets, indices) over raw or other derived instruments.
+// value = constant + sum(weight * leg), applied to both the price and the extra field (so a
+// bond spread also yields a yield spread). Legs must exist (have had an update, or be derived)
+// before a formula referencing them is defined, which keeps the dependency graph acyclic and
+// gives every derived instrument a level one above its deepest derived leg. Updates only mark
+// direct dependents dirty; flush() then recomputes each dirty instrument once, level by level,
+// so a cycle of many leg updates costs one evaluation per affected derived instrument. Nodes
+// are indexed directly by the publisher's dense instrument index.
+class DerivedEngine {
+private:
+    struct Term {
+        uint32_t node;
+        double weight;
+    };
+
+    struct Node {
+        double price = 0;
+        double extra = 0;
+        bool known = false; // A leg or a derived instrument
+        bool haveValue = false;
+        bool derived = false;
+        bool dirty = false;
+        uint32_t level = 0;
+        double constant = 0;
+        std::vector<Term> terms;
+        std::vector<uint32_t> dependents;
+    };
+
+    std::vector<Node> nodes_; // Per instrument index
+    std::vector<std::vector<uint32_t>> dirtyByLevel_;
+
+    Node& node_for(uint32_t instrument) {
+        if (instrument >= nodes_.size()) {
+            nodes_.resize(instrument + 1);
+        }
+        Node& node = nodes_[instrument];
+        node.known = true;
+        return node;
+    }
+
+    void mark_dependents(const Node& node) {
+        for (uint32_t dependent : node.dependents) {
+            Node& target = nodes_[dependent];
+            if (!target.dirty) {
+                target.dirty = true;
+                dirtyByLevel_[target.level].push_back(dependent);
+            }
+        }
+    }
+
+public:
+    bool is_derived(uint32_t instrument) const {
+        return instrument < nodes_.size() && nodes_[instrument].derived;
+    }
+
+    // Defines a derived instrument; it is computed at the next flush once every leg has a value
+    void define(uint32_t node, const std::vector<IndexedLeg>& legs, double constant = 0) {
+        if (legs.empty()) {
+            throw std::invalid_argument("Derived instrument needs at least one leg");
+        }
+        if (node < nodes_.size() && nodes_[node].known) {
+            throw std::invalid_argument("Instrument ID already in use");
+        }
+        std::vector<Term> terms;
+        uint32_t level = 1;
+        for (const IndexedLeg& leg : legs) {
+            if (leg.instrument == node) {
+                throw std::invalid_argument("Derived instrument cannot reference itself");
+            }
+            if (leg.instrument >= nodes_.size() || !nodes_[leg.instrument].known) {
+                throw std::invalid_argument("Unknown leg instrument");
+            }
+            const Node& legNode = nodes_[leg.instrument];
+            terms.push_back({leg.instrument, leg.weight});
+            if (legNode.level + 1 > level) {
+                level = legNode.level + 1;
+            }
+        }
+
+        Node& derived = node_for(node);
+        derived.derived = true;
+        derived.level = level;
+        derived.constant = constant;
+        derived.terms = std::move(terms);
+        for (const Term& term : derived.terms) {
+            nodes_[term.node].dependents.push_back(node);
+        }
+        if (dirtyByLevel_.size() <= level) {
+            dirtyByLevel_.resize(level + 1);
+        }
+        derived.dirty = true;
+        dirtyByLevel_[level].push_back(node);
+    }
+
+    // Records a raw instrument's value; dependents are recomputed at the next flush
+    void on_update(uint32_t instrument, double price, double extra) {
+        Node& node = node_for(instrument);
+        node.price = price;
+        node.extra = extra;
+        node.haveValue = true;
+        mark_dependents(node);
+    }
+
+    // Recomputes every dirty derived instrument once and calls publish(index, price, extra) for it
+    template <typename Publish> void flush(Publish&& publish) {
+        for (uint32_t level = 1; level < dirtyByLevel_.size(); ++level) {
+            // Entries are only ever added to deeper levels while this one is processed
+            for (uint32_t index : dirtyByLevel_[level]) {
+                Node& node = nodes_[index];
+                node.dirty = false;
+
+                double price = node.constant;
+                double extra = node.constant;
+                bool complete = true;
+                for (const Term& term : node.terms) {
+                    const Node& leg = nodes_[term.node];
+                    complete = complete && leg.haveValue;
+                    price += term.weight * leg.price;
+                    extra += term.weight * leg.extra;
+                }
+                if (!complete) {
+                    continue;
+                }
+                node.price = price;
+                node.extra = extra;
+                node.haveValue = true;
+                mark_dependents(node);
+                publish(index, price, extra);
+            }
+            dirtyByLevel_[level].clear();
+        }
+    }
+};
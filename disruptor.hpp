@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "wait_strategy.hpp"
+
+// Monotonic progress counter of a producer or stage, alone on its cache line
+class alignas(64) Sequence {
+private:
+    std::atomic<int64_t> value_{-1};
+
+public:
+    int64_t get() const { return value_.load(std::memory_order_acquire); }
+    void set(int64_t value) { value_.store(value, std::memory_order_release); }
+};
+
+// Pre-allocated single-producer ring of events. The producer claims a sequence, fills the slot
+// in place and publishes it; slots are reused once every gating (last) stage has moved past
+// them, so steady-state ingestion never allocates. Every cursor or stage advance notifies the
+// ring's wake-up channel, so producers and stages may wait by any WaitStrategy, blocking included.
+template <typename Event> class RingBuffer {
+private:
+    std::vector<Event> entries_;
+    int64_t mask_;
+    Sequence cursor_;
+    std::vector<const Sequence*> gating_;
+    int64_t next_ = -1;
+    int64_t cachedGate_ = -1; // Producer-local copy of the slowest gating sequence
+    WaitStrategy producerWait_;
+    WakeupChannel wakeup_;
+
+    int64_t slowest_gate() const {
+        int64_t slowest = std::numeric_limits<int64_t>::max();
+        for (const Sequence* sequence : gating_) {
+            slowest = std::min(slowest, sequence->get());
+        }
+        return gating_.empty() ? next_ : slowest;
+    }
+
+public:
+    explicit RingBuffer(std::size_t capacity, WaitStrategy producerWait = {})
+        : entries_(capacity), mask_(static_cast<int64_t>(capacity) - 1), producerWait_(producerWait) {
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+            throw std::invalid_argument("Ring capacity must be a power of two");
+        }
+    }
+
+    // Registers a stage whose progress frees slots; set up before the producer starts
+    void add_gating(const Sequence& sequence) { gating_.push_back(&sequence); }
+
+    // Next sequence to fill, waiting while the ring is full (single producer only)
+    int64_t claim() {
+        int64_t sequence = ++next_;
+        int64_t wrapPoint = sequence - static_cast<int64_t>(entries_.size());
+        if (wrapPoint > cachedGate_) {
+            wakeup_.wait(producerWait_, [&] { return wrapPoint <= (cachedGate_ = slowest_gate()); });
+        }
+        return sequence;
+    }
+
+    Event& operator[](int64_t sequence) { return entries_[sequence & mask_]; }
+
+    void publish(int64_t sequence) {
+        cursor_.set(sequence);
+        wakeup_.notify();
+    }
+
+    const Sequence& cursor() const { return cursor_; }
+
+    WakeupChannel& wakeup() { return wakeup_; }
+};
+
+// Tells a stage how far it may read: the producer's cursor, capped by the stages it depends on
+class SequenceBarrier {
+public:
+    static constexpr int64_t kHalted = std::numeric_limits<int64_t>::min();
+
+private:
+    const Sequence& cursor_;
+    std::vector<const Sequence*> dependencies_;
+    const std::atomic<bool>& halted_;
+    WakeupChannel& wakeup_;
+    WaitStrategy wait_;
+
+    int64_t available() const {
+        int64_t highest = cursor_.get();
+        for (const Sequence* dependency : dependencies_) {
+            highest = std::min(highest, dependency->get());
+        }
+        return highest;
+    }
+
+public:
+    SequenceBarrier(const Sequence& cursor, std::vector<const Sequence*> dependencies, const std::atomic<bool>& halted,
+                    WakeupChannel& wakeup, WaitStrategy wait)
+        : cursor_(cursor), dependencies_(std::move(dependencies)), halted_(halted), wakeup_(wakeup), wait_(wait) {}
+
+    const WaitStrategy& strategy() const { return wait_; }
+
+    // Highest readable sequence (>= sequence), or kHalted once the stage is being stopped
+    int64_t wait_for(int64_t sequence) const {
+        int64_t highest = available();
+        if (highest >= sequence) {
+            return highest;
+        }
+        bool halted = false;
+        wakeup_.wait(wait_, [&] {
+            highest = available();
+            halted = halted_.load(std::memory_order_acquire);
+            return highest >= sequence || halted;
+        });
+        return highest >= sequence ? highest : kHalted;
+    }
+};
+
+// One consumer stage on its own thread. It handles every event its barrier releases, in
+// batches, then advances its sequence so dependent stages and the producer can proceed.
+// The stage waits by its own WaitStrategy and, if the strategy names a CPU, pins its thread there.
+template <typename Event> class BatchStage {
+public:
+    // handler(event, sequence, endOfBatch)
+    using Handler = std::function<void(Event&, int64_t, bool)>;
+
+private:
+    RingBuffer<Event>& ring_;
+    Sequence sequence_;
+    std::atomic<bool> halted_{false};
+    SequenceBarrier barrier_;
+    Handler handler_;
+    std::thread thread_;
+
+    void run() {
+        int64_t next = sequence_.get() + 1;
+        for (;;) {
+            int64_t available = barrier_.wait_for(next);
+            if (available == SequenceBarrier::kHalted) {
+                return;
+            }
+            for (; next <= available; ++next) {
+                handler_(ring_[next], next, next == available);
+            }
+            sequence_.set(available);
+            ring_.wakeup().notify();
+        }
+    }
+
+public:
+    BatchStage(RingBuffer<Event>& ring, std::vector<const Sequence*> dependencies, Handler handler, WaitStrategy wait = {})
+        : ring_(ring), barrier_(ring.cursor(), std::move(dependencies), halted_, ring.wakeup(), wait),
+          handler_(std::move(handler)) {}
+
+    ~BatchStage() { halt(); }
+
+    const Sequence& sequence() const { return sequence_; }
+
+    // Throws std::runtime_error (with no thread left running) if the thread can't be pinned
+    void start() {
+        std::promise<bool> pinned;
+        std::future<bool> pinResult = pinned.get_future();
+        thread_ = std::thread([this, &pinned] {
+            bool ok = pin_current_thread(barrier_.strategy().cpu);
+            pinned.set_value(ok);
+            if (ok) {
+                run();
+            }
+        });
+        if (!pinResult.get()) {
+            thread_.join();
+            throw std::runtime_error("Failed to pin stage thread to CPU " + std::to_string(barrier_.strategy().cpu));
+        }
+    }
+
+    // Stops after the events already released to this stage; call drain first to lose none
+    void halt() {
+        halted_.store(true, std::memory_order_release);
+        ring_.wakeup().notify();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    // Waits until this stage has handled everything up to the given sequence, by the caller's
+    // strategy (the stage's own by default)
+    void drain(int64_t sequence, const WaitStrategy& wait) const {
+        ring_.wakeup().wait(wait, [&] { return sequence_.get() >= sequence; });
+    }
+
+    void drain(int64_t sequence) const { drain(sequence, barrier_.strategy()); }
+};
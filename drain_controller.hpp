@@ -0,0 +1,309 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <utility>
+
+namespace rvn
+{
+
+/**
+ * @brief Relay-wide drain state for graceful restarts
+ *
+ * begin_drain() flips the relay into draining and bumps the drain epoch. Each session compares
+ * the epoch with the last one it acted on, on its own thread, and sends GOAWAY pointing at the
+ * new session URI when it changed (sessions set up later do so right after SERVER_SETUP). New
+ * subscribes are refused, and groups already being delivered are allowed to finish.
+ * drained() turns true once no group is in flight or the deadline has passed, at which point
+ * the process can exit without cutting media mid-group. All queries are lock-free so they can
+ * sit on the subscribe and object paths.
+ */
+class DrainController
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    std::atomic<bool> draining{false};
+    std::atomic<std::uint64_t> drainEpoch{0}; // Bumped by every begin_drain()
+    std::atomic<std::int64_t> groupsInFlight{0};
+    std::atomic<Clock::rep> deadline{0};
+    mutable std::mutex uriMutex; // Only for the URI string, read once per connection
+    std::string newSessionUri;
+
+public:
+    /**
+     * @brief Starts draining; every session sends GOAWAY the next time it polls the epoch
+     * @param uri Where clients should reconnect (empty: reconnect to the same address)
+     * @param gracePeriod Upper bound on waiting for in-flight groups
+     *
+     * Nothing runs on behalf of the sessions here, so this is safe from any thread. Calling it
+     * again (e.g. with a corrected URI) makes every session send a fresh GOAWAY.
+     */
+    void begin_drain(std::string uri, Clock::duration gracePeriod)
+    {
+        {
+            std::lock_guard<std::mutex> lock(uriMutex);
+            newSessionUri = std::move(uri);
+        }
+        deadline.store((Clock::now() + gracePeriod).time_since_epoch().count(),
+                       std::memory_order_relaxed);
+        draining.store(true, std::memory_order_release);
+        drainEpoch.fetch_add(1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Number of begin_drain() calls so far; 0 while the relay has never drained
+     */
+    std::uint64_t drain_epoch() const
+    {
+        return drainEpoch.load(std::memory_order_acquire);
+    }
+
+    bool is_draining() const
+    {
+        return draining.load(std::memory_order_acquire);
+    }
+
+    bool accepting_subscribes() const
+    {
+        return !is_draining();
+    }
+
+    std::string goaway_uri() const
+    {
+        std::lock_guard<std::mutex> lock(uriMutex);
+        return newSessionUri;
+    }
+
+    /**
+     * @brief Brackets delivery of one group so draining can wait for it to complete
+     */
+    void group_started()
+    {
+        groupsInFlight.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void group_finished()
+    {
+        groupsInFlight.fetch_sub(1, std::memory_order_release);
+    }
+
+    /**
+     * @brief True once draining and either every in-flight group finished or time ran out
+     */
+    bool drained(Clock::time_point now = Clock::now()) const
+    {
+        if (!is_draining())
+        {
+            return false;
+        }
+        return groupsInFlight.load(std::memory_order_acquire) <= 0 ||
+               now.time_since_epoch().count() >= deadline.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief Token bucket limiting how fast a relay admits new sessions or subscribes
+ *
+ * When a peer relay drains, its clients land on the survivors. Admitting them at a bounded
+ * rate (with burst) keeps setup and subscribe handling from starving media delivery;
+ * refused clients back off through their ReconnectPacer and retry. A rate of 0 or less
+ * admits everything. Lock-free.
+ */
+class AdmissionLimiter
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    // Tokens are kept in millitokens so refill stays integral
+    std::atomic<std::int64_t> milliTokens;
+    std::atomic<Clock::rep> lastRefill;
+    std::atomic<std::int64_t> ratePerSecond;
+    std::atomic<std::int64_t> burstMilliTokens;
+
+    void refill(Clock::rep nowTicks)
+    {
+        Clock::rep previous = lastRefill.load(std::memory_order_relaxed);
+        std::int64_t rate = ratePerSecond.load(std::memory_order_relaxed);
+        std::int64_t burstMilli = burstMilliTokens.load(std::memory_order_relaxed);
+        if (nowTicks <= previous || rate <= 0)
+        {
+            return;
+        }
+
+        // lastRefill only moves by the time the credited millitokens account for, so calls
+        // closer together than one millitoken keep accumulating instead of losing the
+        // remainder. After long enough to fill the bucket the idle time is not banked.
+        std::int64_t elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                                     Clock::duration(nowTicks - previous))
+                                     .count();
+        std::int64_t credit;
+        Clock::rep advanced;
+        if (elapsedUs >= burstMilli * 1000 / rate + 1)
+        {
+            credit = burstMilli;
+            advanced = nowTicks;
+        }
+        else
+        {
+            credit = elapsedUs * rate / 1000;
+            if (credit == 0)
+            {
+                return;
+            }
+            std::int64_t creditedUs = (credit * 1000 + rate - 1) / rate;
+            advanced = previous + std::chrono::duration_cast<Clock::duration>(
+                                      std::chrono::microseconds(creditedUs))
+                                      .count();
+        }
+
+        // Whoever advances lastRefill credits the time it covered
+        if (lastRefill.compare_exchange_strong(previous, advanced, std::memory_order_relaxed))
+        {
+            std::int64_t current = milliTokens.load(std::memory_order_relaxed);
+            std::int64_t refilled;
+            do
+            {
+                refilled = std::min(burstMilli, current + credit);
+            } while (!milliTokens.compare_exchange_weak(current, refilled,
+                                                        std::memory_order_relaxed));
+        }
+    }
+
+public:
+    AdmissionLimiter(std::int64_t ratePerSecond, std::int64_t burst)
+        : milliTokens(burst * 1000), lastRefill(Clock::now().time_since_epoch().count()),
+          ratePerSecond(ratePerSecond), burstMilliTokens(burst * 1000)
+    {
+    }
+
+    /**
+     * @brief Changes the admission rate and burst (e.g. from configuration at startup)
+     *
+     * The bucket restarts full; a rate of 0 or less turns limiting off.
+     */
+    void configure(std::int64_t newRatePerSecond, std::int64_t burst)
+    {
+        ratePerSecond.store(newRatePerSecond, std::memory_order_relaxed);
+        burstMilliTokens.store(burst * 1000, std::memory_order_relaxed);
+        milliTokens.store(burst * 1000, std::memory_order_relaxed);
+        lastRefill.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Takes one admission if available; always succeeds while limiting is off
+     */
+    bool try_admit(Clock::time_point now = Clock::now())
+    {
+        if (ratePerSecond.load(std::memory_order_relaxed) <= 0)
+        {
+            return true;
+        }
+        refill(now.time_since_epoch().count());
+
+        std::int64_t current = milliTokens.load(std::memory_order_relaxed);
+        while (current >= 1000)
+        {
+            if (milliTokens.compare_exchange_weak(current, current - 1000,
+                                                  std::memory_order_relaxed))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+/**
+ * @brief Client-side reconnect pacing after GOAWAY or connection loss
+ *
+ * The first attempt after a GOAWAY is spread uniformly over goawaySpread so that a
+ * relay's whole audience does not reconnect in the same instant; subsequent failures
+ * back off exponentially with full jitter (uniform in [0, min(cap, base * 2^attempt))).
+ */
+class ReconnectPacer
+{
+public:
+    using Duration = std::chrono::milliseconds;
+
+private:
+    Duration base;
+    Duration cap;
+    Duration goawaySpread;
+    unsigned attempt = 0;
+    std::mt19937_64 rng;
+
+    Duration uniform(Duration upper)
+    {
+        if (upper.count() <= 0)
+        {
+            return Duration(0);
+        }
+        return Duration(std::uniform_int_distribution<Duration::rep>(0, upper.count())(rng));
+    }
+
+public:
+    ReconnectPacer(Duration base = Duration(100), Duration cap = Duration(30'000),
+                   Duration goawaySpread = Duration(5'000),
+                   std::uint64_t seed = std::random_device{}())
+        : base(base), cap(cap), goawaySpread(goawaySpread), rng(seed)
+    {
+    }
+
+    /**
+     * @brief Delay before reconnecting after a GOAWAY
+     */
+    Duration after_goaway()
+    {
+        attempt = 0;
+        return uniform(goawaySpread);
+    }
+
+    /**
+     * @brief Delay before the next attempt after a failed or refused connect
+     */
+    Duration after_failure()
+    {
+        unsigned shift = std::min(attempt, 20u);
+        attempt++;
+        Duration ceiling = std::min(cap, Duration(base.count() << shift));
+        return uniform(ceiling);
+    }
+
+    /**
+     * @brief Resets backoff once a session is established
+     */
+    void on_connected()
+    {
+        attempt = 0;
+    }
+};
+
+/**
+ * @brief Process-wide drain state consulted by every connection's message handler
+ */
+inline DrainController& drain_controller()
+{
+    static DrainController controller;
+    return controller;
+}
+
+/**
+ * @brief Process-wide limiter on new sessions, consulted on CLIENT_SETUP
+ *
+ * Off until configure() gives it a positive rate.
+ */
+inline AdmissionLimiter& admission_limiter()
+{
+    static AdmissionLimiter limiter(0, 0);
+    return limiter;
+}
+
+} // namespace rvn
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// Data structure to hold instrument data
+struct InstrumentData {
+    uint64_t instrumentId;
+    double lastTradedPrice;
+    double extraData; // Bond yield or last day volume based on publisher type
+};
+
+enum class ScanField : uint8_t { Price, Extra };
+
+// Screener query: range predicates on both fields, then the top `limit` by one field
+struct ScanQuery {
+    double minPrice = -std::numeric_limits<double>::infinity();
+    double maxPrice = std::numeric_limits<double>::infinity();
+    double minExtra = -std::numeric_limits<double>::infinity();
+    double maxExtra = std::numeric_limits<double>::infinity();
+    ScanField sortBy = ScanField::Price;
+    bool descending = true;
+    std::size_t limit = std::numeric_limits<std::size_t>::max();
+    unsigned shards = 1; // Slices scanned on separate threads for large stores
+};
+
+// Columnar instrument store: IDs, prices and extra fields live in parallel arrays indexed by the
+// publisher's dense instrument index, so a point lookup is an array access. Rows of instruments
+// without data yet hold NaN, which every scan predicate rejects. Scans evaluate predicates over
+// the two value columns in fixed-size batches with a branch-free mask (auto-vectorized), run
+// the entitlement check only for matches, and keep a partial top-K per shard that is merged
+// at the end.
+class InstrumentStore {
+private:
+    static constexpr std::size_t kBatch = 256;
+    static constexpr std::size_t kMinShardSize = 16384;
+
+    std::vector<uint64_t> ids_;
+    std::vector<double> prices_;
+    std::vector<double> extras_;
+    std::vector<uint8_t> present_;
+
+    // Orders row indices by the query's sort field, ties by instrument ID
+    auto comparator(const ScanQuery& query) const {
+        const double* column = query.sortBy == ScanField::Price ? prices_.data() : extras_.data();
+        const uint64_t* ids = ids_.data();
+        bool descending = query.descending;
+        return [column, ids, descending](uint32_t a, uint32_t b) {
+            if (column[a] != column[b]) {
+                return descending ? column[a] > column[b] : column[a] < column[b];
+            }
+            return ids[a] < ids[b];
+        };
+    }
+
+    template <typename Allow>
+    void scan_range(std::size_t begin, std::size_t end, const ScanQuery& query, const Allow& allowed,
+                    std::vector<uint32_t>& rows) const {
+        const double* prices = prices_.data();
+        const double* extras = extras_.data();
+        uint8_t mask[kBatch];
+        for (std::size_t base = begin; base < end; base += kBatch) {
+            std::size_t count = std::min(kBatch, end - base);
+            for (std::size_t i = 0; i < count; ++i) {
+                double price = prices[base + i];
+                double extra = extras[base + i];
+                mask[i] = (price >= query.minPrice) & (price <= query.maxPrice) &
+                          (extra >= query.minExtra) & (extra <= query.maxExtra);
+            }
+            for (std::size_t i = 0; i < count; ++i) {
+                if (mask[i] && allowed(static_cast<uint32_t>(base + i))) {
+                    rows.push_back(static_cast<uint32_t>(base + i));
+                }
+            }
+        }
+        keep_top(rows, query);
+    }
+
+    void keep_top(std::vector<uint32_t>& rows, const ScanQuery& query) const {
+        auto cmp = comparator(query);
+        if (rows.size() > query.limit) {
+            std::partial_sort(rows.begin(), rows.begin() + query.limit, rows.end(), cmp);
+            rows.resize(query.limit);
+        } else {
+            std::sort(rows.begin(), rows.end(), cmp);
+        }
+    }
+
+public:
+    void upsert(uint32_t row, uint64_t instrumentId, double lastTradedPrice, double extraData) {
+        if (row >= ids_.size()) {
+            ids_.resize(row + 1, 0);
+            prices_.resize(row + 1, std::numeric_limits<double>::quiet_NaN());
+            extras_.resize(row + 1, std::numeric_limits<double>::quiet_NaN());
+            present_.resize(row + 1, 0);
+        }
+        ids_[row] = instrumentId;
+        prices_[row] = lastTradedPrice;
+        extras_[row] = extraData;
+        present_[row] = 1;
+    }
+
+    bool contains(uint32_t row) const { return row < present_.size() && present_[row]; }
+
+    std::optional<InstrumentData> find(uint32_t row) const {
+        if (!contains(row)) {
+            return std::nullopt;
+        }
+        return InstrumentData{ids_[row], prices_[row], extras_[row]};
+    }
+
+    std::size_t size() const { return ids_.size(); }
+
+    // Instruments matching the query and accepted by allowed(row), best first.
+    // allowed may be called concurrently from several shards.
+    template <typename Allow> std::vector<InstrumentData> scan(const ScanQuery& query, Allow&& allowed) const {
+        std::size_t shardCount = std::max<std::size_t>(1, std::min<std::size_t>(query.shards, ids_.size() / kMinShardSize));
+        std::vector<std::vector<uint32_t>> shardRows(shardCount);
+        std::size_t shardSize = (ids_.size() + shardCount - 1) / shardCount;
+        auto runShard = [&](std::size_t shard) {
+            std::size_t begin = shard * shardSize;
+            scan_range(begin, std::min(ids_.size(), begin + shardSize), query, allowed, shardRows[shard]);
+        };
+
+        std::vector<std::thread> workers;
+        for (std::size_t shard = 1; shard < shardCount; ++shard) {
+            workers.emplace_back(runShard, shard);
+        }
+        runShard(0);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+
+        std::vector<uint32_t>& rows = shardRows[0];
+        for (std::size_t shard = 1; shard < shardCount; ++shard) {
+            rows.insert(rows.end(), shardRows[shard].begin(), shardRows[shard].end());
+        }
+        if (shardCount > 1) {
+            keep_top(rows, query);
+        }
+
+        std::vector<InstrumentData> result;
+        result.reserve(rows.size());
+        for (uint32_t row : rows) {
+            result.push_back({ids_[row], prices_[row], extras_[row]});
+        }
+        return result;
+    }
+};
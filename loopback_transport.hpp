@@ -0,0 +1,305 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace rvn
+{
+
+using StreamId = std::uint64_t;
+using SimTime = std::uint64_t; // Nanoseconds of simulated time
+
+/**
+ * @brief Minimal byte transport that relay logic is written against
+ *
+ * Mirrors what the QUIC connection provides to MOQT: reliable, in-order delivery of
+ * messages per stream, with no ordering across streams. The msquic-backed connection and
+ * the in-process LoopbackTransport below are interchangeable behind this interface.
+ */
+class Transport
+{
+public:
+    using ReceiveHandler = std::function<void(StreamId, std::string_view)>;
+
+    virtual ~Transport() = default;
+
+    /**
+     * @brief Queues one message on a stream
+     */
+    virtual void send(StreamId streamId, std::string bytes) = 0;
+
+    /**
+     * @brief Installs the callback invoked for every message delivered to this endpoint
+     */
+    virtual void set_receive_handler(ReceiveHandler handler) = 0;
+
+    /**
+     * @brief Messages sent but not yet delivered to the peer (0 if the transport can't tell)
+     */
+    virtual std::size_t queued() const
+    {
+        return 0;
+    }
+};
+
+/**
+ * @brief Properties of one direction of a simulated link
+ */
+struct LinkConfig
+{
+    SimTime latency = 10'000'000;         // One-way propagation delay (10 ms)
+    std::uint64_t bandwidthBps = 0;       // Bytes per second, 0 for unlimited
+    double lossRate = 0.0;                // Probability a transmission is lost, in [0, 1)
+    SimTime retransmitDelay = 0;          // Extra delay per loss, 0 for 2 x latency (one RTT)
+};
+
+/**
+ * @brief Counters for one direction of a simulated link
+ */
+struct LinkStats
+{
+    std::uint64_t messages = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t losses = 0;     // Transmissions lost and retransmitted
+    SimTime totalDelay = 0;       // Sum of send-to-delivery delays
+};
+
+class LoopbackNetwork;
+
+/**
+ * @brief One endpoint of a simulated connection
+ *
+ * Loss is modelled the way QUIC streams see it: a lost transmission is retransmitted after
+ * retransmitDelay and every later message on the same stream waits for it (head-of-line
+ * blocking), while other streams are unaffected. Every retransmitted copy is serialized again,
+ * so it also delays whatever is queued behind it on the link.
+ */
+class LoopbackTransport : public Transport
+{
+    friend class LoopbackNetwork;
+
+    LoopbackNetwork& network;
+    LinkConfig config;                // Outgoing direction
+    LinkStats stats;
+    LoopbackTransport* peer = nullptr;
+    ReceiveHandler receiveHandler;
+    SimTime linkBusyUntil = 0;        // End of the last serialization on this link
+    std::size_t inFlight = 0;         // Sent and not yet delivered
+    std::unordered_map<StreamId, SimTime> lastDeliveryOnStream; // Streams with messages in flight
+
+    LoopbackTransport(LoopbackNetwork& network, LinkConfig config)
+        : network(network), config(config)
+    {
+    }
+
+public:
+    void send(StreamId streamId, std::string bytes) override;
+
+    void set_receive_handler(ReceiveHandler handler) override
+    {
+        receiveHandler = std::move(handler);
+    }
+
+    std::size_t queued() const override
+    {
+        return inFlight;
+    }
+
+    /**
+     * @brief Streams with messages still in flight on this endpoint's outgoing link
+     */
+    std::size_t active_streams() const
+    {
+        return lastDeliveryOnStream.size();
+    }
+
+    const LinkStats& link_stats() const
+    {
+        return stats;
+    }
+};
+
+/**
+ * @brief Discrete-event, single-threaded network of loopback connections
+ *
+ * Everything runs on simulated time, so publisher -> relay -> relay -> subscriber topologies
+ * with thousands of nodes run in one process, deterministically for a given seed, and far
+ * faster than real time. Node logic runs inside receive handlers and may send or schedule
+ * further work.
+ */
+class LoopbackNetwork
+{
+    struct Event
+    {
+        SimTime time;
+        std::uint64_t sequence; // FIFO order among events at the same time
+        std::function<void()> action;
+
+        bool operator>(const Event& other) const
+        {
+            return time != other.time ? time > other.time : sequence > other.sequence;
+        }
+    };
+
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+    std::vector<std::unique_ptr<LoopbackTransport>> endpoints;
+    std::mt19937_64 rng;
+    SimTime currentTime = 0;
+    std::uint64_t nextSequence = 0;
+
+    friend class LoopbackTransport;
+
+    bool lost(double lossRate)
+    {
+        return lossRate > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(rng) < lossRate;
+    }
+
+    static void validate(const LinkConfig& config)
+    {
+        // At 1.0 every retransmission would be lost too
+        if (!(config.lossRate >= 0.0 && config.lossRate < 1.0))
+        {
+            throw std::invalid_argument("LinkConfig lossRate must be in [0, 1)");
+        }
+    }
+
+public:
+    explicit LoopbackNetwork(std::uint64_t seed = 1) : rng(seed) {}
+
+    /**
+     * @brief Creates a connected pair of endpoints
+     * @param aToB Link properties from the first endpoint to the second
+     * @param bToA Link properties from the second endpoint to the first
+     * @throws std::invalid_argument if a loss rate is outside [0, 1)
+     */
+    std::pair<LoopbackTransport*, LoopbackTransport*> connect(const LinkConfig& aToB,
+                                                              const LinkConfig& bToA)
+    {
+        validate(aToB);
+        validate(bToA);
+        endpoints.emplace_back(new LoopbackTransport(*this, aToB));
+        LoopbackTransport* a = endpoints.back().get();
+        endpoints.emplace_back(new LoopbackTransport(*this, bToA));
+        LoopbackTransport* b = endpoints.back().get();
+        a->peer = b;
+        b->peer = a;
+        return {a, b};
+    }
+
+    std::pair<LoopbackTransport*, LoopbackTransport*> connect(const LinkConfig& symmetric = {})
+    {
+        return connect(symmetric, symmetric);
+    }
+
+    /**
+     * @brief Runs an action at an absolute simulated time (e.g. a publisher's next object)
+     */
+    void schedule(SimTime at, std::function<void()> action)
+    {
+        events.push({at < currentTime ? currentTime : at, nextSequence++, std::move(action)});
+    }
+
+    SimTime now() const
+    {
+        return currentTime;
+    }
+
+    /**
+     * @brief Processes events up to and including the given time
+     * @return Number of events processed
+     */
+    std::size_t run_until(SimTime until)
+    {
+        std::size_t processed = 0;
+        while (!events.empty() && events.top().time <= until)
+        {
+            Event event = std::move(const_cast<Event&>(events.top()));
+            events.pop();
+            currentTime = event.time;
+            event.action();
+            processed++;
+        }
+        if (currentTime < until)
+        {
+            currentTime = until;
+        }
+        return processed;
+    }
+
+    /**
+     * @brief Processes events until the network is idle
+     */
+    std::size_t run()
+    {
+        std::size_t processed = 0;
+        while (!events.empty())
+        {
+            processed += run_until(events.top().time);
+        }
+        return processed;
+    }
+};
+
+inline void LoopbackTransport::send(StreamId streamId, std::string bytes)
+{
+    SimTime now = network.now();
+
+    // Serialization delay on the sender's side of the link
+    SimTime start = linkBusyUntil > now ? linkBusyUntil : now;
+    SimTime serialization =
+        config.bandwidthBps ? bytes.size() * 1'000'000'000ull / config.bandwidthBps : 0;
+    linkBusyUntil = start + serialization;
+
+    SimTime arrival = linkBusyUntil + config.latency;
+    SimTime retransmitDelay = config.retransmitDelay ? config.retransmitDelay : 2 * config.latency;
+    while (network.lost(config.lossRate))
+    {
+        // The retransmitted copy occupies the link like the original did
+        linkBusyUntil += serialization;
+        arrival += retransmitDelay + serialization;
+        stats.losses++;
+    }
+
+    // In-order delivery per stream
+    SimTime& lastDelivery = lastDeliveryOnStream[streamId];
+    if (arrival < lastDelivery)
+    {
+        arrival = lastDelivery;
+    }
+    lastDelivery = arrival;
+
+    stats.messages++;
+    stats.bytes += bytes.size();
+    stats.totalDelay += arrival - now;
+    inFlight++;
+
+    LoopbackTransport* sender = this;
+    LoopbackTransport* receiver = peer;
+    network.schedule(arrival, [sender, receiver, streamId, arrival, payload = std::move(bytes)]() {
+        sender->inFlight--;
+
+        // Forget the stream once its last queued message is delivered, so one-shot streams
+        // don't accumulate entries
+        auto last = sender->lastDeliveryOnStream.find(streamId);
+        if (last != sender->lastDeliveryOnStream.end() && last->second == arrival)
+        {
+            sender->lastDeliveryOnStream.erase(last);
+        }
+
+        if (receiver->receiveHandler)
+        {
+            receiver->receiveHandler(streamId, payload);
+        }
+    });
+}
+
+} // namespace rvn
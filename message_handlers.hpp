@@ -1,7 +1,17 @@
 #pragma once
 
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include <drain_controller.hpp>
+#include <metrics.hpp>
 #include <moqt.hpp>
 #include <serialization.hpp>
+#include <serialization_reuse.hpp>
+#include <subscription_table.hpp>
+#include <track_interner.hpp>
 
 namespace rvn
 {
@@ -17,6 +27,56 @@ template <typename MOQTObject> class MessageHandler
 {
     MOQTObject& moqt;                  // Reference to the main MOQT object
     ConnectionState& connectionState;   // Reference to the current connection state
+    SubscriptionTable<> subscriptions;  // Subscriptions we issued, by the subscribe ID we allocated
+    std::uint64_t connectionId;         // Label for this connection's metric series
+
+    // Subscriptions the peer issued to us, by the subscribe ID the peer chose
+    std::unordered_map<std::uint64_t, TrackAlias> peerSubscriptions;
+
+    static constexpr std::uint64_t subscribeErrorInternal = 0; // SUBSCRIBE_ERROR code
+
+    /**
+     * @brief Progress of version negotiation on this connection
+     */
+    enum class SetupState
+    {
+        AwaitingSetup, // No setup exchange completed yet; SUBSCRIBEs are held
+        Established,   // Version negotiated; SUBSCRIBEs are handled on arrival
+        Rejected       // Negotiation failed; held and later SUBSCRIBEs are refused
+    };
+
+    SetupState setupState = SetupState::AwaitingSetup;
+
+    // SUBSCRIBEs pipelined ahead of setup, replayed in arrival order once it completes
+    static constexpr std::size_t maxPendingSubscribes = 16;
+    std::vector<protobuf_messages::SubscribeMessage> pendingSubscribes;
+
+    // One decoded message object per type, cleared and reparsed in place for every message
+    // so string and repeated-field capacity survives across messages on this connection
+    std::tuple<protobuf_messages::ClientSetupMessage, protobuf_messages::ServerSetupMessage,
+               protobuf_messages::SubscribeMessage, protobuf_messages::UnsubscribeMessage,
+               protobuf_messages::ObjectStreamMessage, protobuf_messages::GoAwayMessage>
+        messageCache;
+
+    bool goAwayReceived = false; // Peer asked us to migrate this session
+    std::string goAwayUri;       // Where to reconnect (empty: same endpoint)
+    ReconnectPacer reconnectPacer;
+    ReconnectPacer::Duration reconnectDelay{0}; // Set from reconnectPacer on GOAWAY
+
+    bool goAwayEligible = false; // SERVER_SETUP sent, so GOAWAY may follow on this session
+    std::uint64_t goAwayEpoch = 0; // Last drain epoch a GOAWAY was sent for
+
+    /**
+     * @brief Stops counting a subscription's current group as in flight
+     */
+    static void finish_group(SubscriptionState& subscription)
+    {
+        if (subscription.groupOpen)
+        {
+            subscription.groupOpen = false;
+            drain_controller().group_finished();
+        }
+    }
 
     /**
      * @brief Handles the initial setup message from a client
@@ -25,13 +85,24 @@ template <typename MOQTObject> class MessageHandler
      * @return QUIC_STATUS indicating success or failure
      *
      * Process:
-     * 1. Verifies version compatibility between client and server
-     * 2. Extracts connection parameters (path, peer role)
-     * 3. Responds with a SERVER_SETUP message
+     * 1. Refuses the session if the admission limiter is out of tokens
+     * 2. Verifies version compatibility between client and server
+     * 3. Extracts connection parameters (path, peer role)
+     * 4. Responds with a SERVER_SETUP message
+     * 5. Sends GOAWAY right away if the relay is already draining
+     * 6. Handles SUBSCRIBEs that were pipelined ahead of the setup
      */
     QUIC_STATUS
     handle_message(ConnectionState&, protobuf_messages::ClientSetupMessage&& clientSetupMessage)
     {
+        // Bound the rate of new sessions, e.g. when a draining peer's clients arrive at once
+        if (!admission_limiter().try_admit())
+        {
+            utils::LOG_EVENT(std::cout, "Refusing session: admission limit reached");
+            reject_pending_subscribes();
+            return QUIC_STATUS_INVALID_PARAMETER;
+        }
+
         // Check if the client supports our version
         auto& supportedversions = clientSetupMessage.supportedversions();
         auto matchingVersionIter =
@@ -41,6 +112,7 @@ template <typename MOQTObject> class MessageHandler
         if (matchingVersionIter == supportedversions.end())
         {
             // TODO: Implement connection destruction
+            reject_pending_subscribes();
             return QUIC_STATUS_INVALID_PARAMETER;
         }
 
@@ -70,6 +142,13 @@ template <typename MOQTObject> class MessageHandler
 
         connectionState.enqueue_control_buffer(quicBuffer);
 
+        // Eligible only once SERVER_SETUP is queued, so a GOAWAY always follows it; a relay
+        // that is already draining sends it right away
+        goAwayEligible = true;
+        poll_drain();
+
+        replay_pending_subscribes();
+
         return QUIC_STATUS_SUCCESS;
     }
 
@@ -98,6 +177,9 @@ template <typename MOQTObject> class MessageHandler
         // Store server's role and mark control stream for shutdown
         connectionState.peerRole = serverSetupMessage.parameters()[0].role().role();
         connectionState.expectControlStreamShutdown = true;
+        reconnectPacer.on_connected();
+
+        replay_pending_subscribes();
 
         return QUIC_STATUS_SUCCESS;
     }
@@ -110,6 +192,13 @@ template <typename MOQTObject> class MessageHandler
      *
      * Processes subscription requests for media content. Currently contains commented-out
      * validation logic that would verify proper message format and parameters.
+     * A SUBSCRIBE may be pipelined right behind CLIENT_SETUP. Until setup completes it is held
+     * in a bounded queue. It is replayed in arrival order once setup succeeds, and rejected
+     * with SUBSCRIBE_ERROR if setup fails.
+     * The full track name is interned here, once per accepted subscription, so later
+     * processing can work with the dense TrackAlias instead of strings. The subscription is
+     * kept under the subscribe ID the peer chose and confirmed with SUBSCRIBE_OK; a subscribe
+     * that is rejected or fails to register is answered with SUBSCRIBE_ERROR instead.
      */
     QUIC_STATUS handle_message(ConnectionState&, protobuf_messages::SubscribeMessage&& subscribeMessage)
     {
@@ -121,31 +210,240 @@ template <typename MOQTObject> class MessageHandler
         utils::LOG_EVENT(std::cout, "Subscribe Message received: \n",
                         subscribeMessage.DebugString());
 
-        // Register the subscription with the MOQT object
-        auto err =
-            moqt.try_register_subscription(connectionState, std::move(subscribeMessage));
+        switch (setupState)
+        {
+        case SetupState::Established:
+            return accept_subscribe(subscribeMessage);
+
+        case SetupState::Rejected:
+            send_subscribe_error(subscribeMessage.subscribeid(), "Setup failed");
+            return QUIC_STATUS_INVALID_PARAMETER;
+
+        case SetupState::AwaitingSetup:
+            break;
+        }
+
+        if (subscribeMessage.trackname().empty())
+        {
+            utils::LOG_EVENT(std::cout, "Rejecting subscribe without a track name");
+            send_subscribe_error(subscribeMessage.subscribeid(), "Missing track name");
+            return QUIC_STATUS_INVALID_PARAMETER;
+        }
+
+        if (pendingSubscribes.size() == maxPendingSubscribes)
+        {
+            utils::LOG_EVENT(std::cout, "Rejecting subscribe: too many ahead of setup");
+            send_subscribe_error(subscribeMessage.subscribeid(), "Too many subscribes before setup");
+            return QUIC_STATUS_INVALID_PARAMETER;
+        }
+
+        // Copied: the cached message is reparsed for the next SUBSCRIBE
+        pendingSubscribes.push_back(subscribeMessage);
+        return QUIC_STATUS_SUCCESS;
+    }
+
+    /**
+     * @brief Accepts or rejects a SUBSCRIBE once setup has completed
+     */
+    QUIC_STATUS accept_subscribe(protobuf_messages::SubscribeMessage& subscribeMessage)
+    {
+        std::uint64_t subscribeId = subscribeMessage.subscribeid();
+
+        // While draining, in-flight groups complete but no new subscriptions start
+        if (!drain_controller().accepting_subscribes())
+        {
+            utils::LOG_EVENT(std::cout, "Rejecting subscribe while draining");
+            send_subscribe_error(subscribeId, "Draining");
+            return QUIC_STATUS_INVALID_PARAMETER;
+        }
+
+        if (subscribeMessage.trackname().empty())
+        {
+            utils::LOG_EVENT(std::cout, "Rejecting subscribe without a track name");
+            send_subscribe_error(subscribeId, "Missing track name");
+            return QUIC_STATUS_INVALID_PARAMETER;
+        }
+
+        if (peerSubscriptions.count(subscribeId) != 0)
+        {
+            utils::LOG_EVENT(std::cout, "Rejecting duplicate subscribe ID: ", subscribeId);
+            send_subscribe_error(subscribeId, "Duplicate subscribe ID");
+            return QUIC_STATUS_INVALID_PARAMETER;
+        }
+
+        // Resolve the full track name to its internal alias; rejected subscribes never get here
+        TrackAlias trackAlias = track_interner().intern(subscribeMessage.tracknamespace(),
+                                                        subscribeMessage.trackname());
+        utils::LOG_EVENT(std::cout, "Track interned with alias: ", trackAlias);
+
+        // Register a copy with the MOQT object; the cached message keeps its buffers for reuse
+        auto err = moqt.try_register_subscription(
+            connectionState, protobuf_messages::SubscribeMessage(subscribeMessage));
+        if (QUIC_FAILED(err))
+        {
+            utils::LOG_EVENT(std::cout, "Subscription registration failed: ", err);
+            send_subscribe_error(subscribeId, "Registration failed");
+            return err;
+        }
+
+        peerSubscriptions.emplace(subscribeId, trackAlias);
+        send_subscribe_ok(subscribeId);
+
+        return QUIC_STATUS_SUCCESS;
+    }
+
+    /**
+     * @brief Marks setup as complete and handles the SUBSCRIBEs held until now
+     */
+    void replay_pending_subscribes()
+    {
+        setupState = SetupState::Established;
+        for (auto& subscribeMessage : pendingSubscribes)
+        {
+            accept_subscribe(subscribeMessage);
+        }
+        pendingSubscribes.clear();
+    }
+
+    /**
+     * @brief Marks setup as failed and rejects the SUBSCRIBEs held until now
+     */
+    void reject_pending_subscribes()
+    {
+        setupState = SetupState::Rejected;
+        for (auto& subscribeMessage : pendingSubscribes)
+        {
+            send_subscribe_error(subscribeMessage.subscribeid(), "Setup failed");
+        }
+        pendingSubscribes.clear();
+    }
+
+    /**
+     * @brief Handles the end of a subscription
+     * @param connectionState Current connection state
+     * @param unsubscribeMessage The message naming the subscribe ID to end
+     * @return QUIC_STATUS indicating success or failure
+     *
+     * Forgets a subscription the peer issued to us, under the subscribe ID the peer chose.
+     */
+    QUIC_STATUS handle_message(ConnectionState&, protobuf_messages::UnsubscribeMessage&& unsubscribeMessage)
+    {
+        utils::LOG_EVENT(std::cout, "Unsubscribe Message received: ",
+                        unsubscribeMessage.DebugString());
+
+        if (peerSubscriptions.erase(unsubscribeMessage.subscribeid()) == 0)
+        {
+            return QUIC_STATUS_INVALID_PARAMETER;
+        }
 
         return QUIC_STATUS_SUCCESS;
     }
 
+    /**
+     * @brief Confirms a subscription under the peer's subscribe ID
+     */
+    void send_subscribe_ok(std::uint64_t subscribeId)
+    {
+        protobuf_messages::MessageHeader subscribeOkHeader;
+        subscribeOkHeader.set_messagetype(protobuf_messages::MoQtMessageType::SUBSCRIBE_OK);
+
+        protobuf_messages::SubscribeOkMessage subscribeOkMessage;
+        subscribeOkMessage.set_subscribeid(subscribeId);
+
+        QUIC_BUFFER* quicBuffer = serialization::serialize(subscribeOkHeader, subscribeOkMessage);
+        connectionState.enqueue_control_buffer(quicBuffer);
+    }
+
+    /**
+     * @brief Rejects a subscription under the peer's subscribe ID
+     */
+    void send_subscribe_error(std::uint64_t subscribeId, const char* reason)
+    {
+        protobuf_messages::MessageHeader subscribeErrorHeader;
+        subscribeErrorHeader.set_messagetype(protobuf_messages::MoQtMessageType::SUBSCRIBE_ERROR);
+
+        protobuf_messages::SubscribeErrorMessage subscribeErrorMessage;
+        subscribeErrorMessage.set_subscribeid(subscribeId);
+        subscribeErrorMessage.set_errorcode(subscribeErrorInternal);
+        subscribeErrorMessage.set_reasonphrase(reason);
+
+        QUIC_BUFFER* quicBuffer =
+            serialization::serialize(subscribeErrorHeader, subscribeErrorMessage);
+        connectionState.enqueue_control_buffer(quicBuffer);
+    }
+
     /**
      * @brief Handles incoming media object stream messages
      * @param connectionState Current connection state
      * @param objectStreamMessage The message containing media object data
      * @return QUIC_STATUS indicating success or failure
      *
-     * Processes incoming media object data and adds it to the appropriate queue
+     * Processes incoming media object data and adds it to the appropriate queue.
+     * The subscribe ID is one we allocated in subscribe() and is resolved through the
+     * connection's subscription slab. Objects for released subscriptions are dropped; IDs
+     * the slab never issued are queued unchanged.
+     * Each subscription's current group counts as in flight for draining until the next group
+     * starts or the subscription ends. Groups that start while draining are not counted.
      */
     QUIC_STATUS
     handle_message(ConnectionState& connectionState,
                   protobuf_messages::ObjectStreamMessage&& objectStreamMessage)
     {
         std::uint64_t subscribeId = objectStreamMessage.subscribeid();
+        SubscriptionState* subscription = subscriptions.find(subscribeId);
+        if (subscription == nullptr)
+        {
+            if (subscriptions.is_stale(subscribeId))
+            {
+                utils::LOG_EVENT(std::cout, "Dropping object for stale subscribe ID: ", subscribeId);
+                return QUIC_STATUS_SUCCESS;
+            }
+            connectionState.add_to_queue(objectStreamMessage.objectpayload());
+            return QUIC_STATUS_SUCCESS;
+        }
+
+        std::uint64_t group = objectStreamMessage.groupid();
+        if (!subscription->groupOpen || subscription->openGroup != group)
+        {
+            finish_group(*subscription);
+            if (!drain_controller().is_draining())
+            {
+                drain_controller().group_started();
+                subscription->groupOpen = true;
+                subscription->openGroup = group;
+            }
+        }
+
+        subscription->objectsReceived++;
+        metrics().record_object(subscription->metricSeries,
+                                objectStreamMessage.objectpayload().size());
+
         connectionState.add_to_queue(objectStreamMessage.objectpayload());
 
         return QUIC_STATUS_SUCCESS;
     }
 
+    /**
+     * @brief Handles a GOAWAY from the peer
+     * @param connectionState Current connection state
+     * @param goAwayMessage The GOAWAY message, optionally carrying a new session URI
+     * @return QUIC_STATUS indicating success or failure
+     *
+     * Records the migration request and draws the reconnect delay from the pacer, spread so a
+     * relay's whole audience does not reconnect at once. The session owner finishes in-flight
+     * groups and reconnects after reconnect_delay().
+     */
+    QUIC_STATUS handle_message(ConnectionState&, protobuf_messages::GoAwayMessage&& goAwayMessage)
+    {
+        utils::LOG_EVENT(std::cout, "GoAway Message received: ", goAwayMessage.DebugString());
+
+        goAwayReceived = true;
+        goAwayUri = goAwayMessage.newsessionuri();
+        reconnectDelay = reconnectPacer.after_goaway();
+
+        return QUIC_STATUS_SUCCESS;
+    }
+
 public:
     /**
      * @brief Constructor for MessageHandler
@@ -153,8 +451,162 @@ public:
      * @param connectionState Reference to the connection state
      */
     MessageHandler(MOQTObject& moqt, ConnectionState& connectionState)
-        : moqt(moqt), connectionState(connectionState)
+        : moqt(moqt), connectionState(connectionState),
+          connectionId(metrics().next_connection_id())
+    {
+    }
+
+    // Open groups are counted with the drain controller; a copy would finish them twice
+    MessageHandler(const MessageHandler&) = delete;
+    MessageHandler& operator=(const MessageHandler&) = delete;
+
+    ~MessageHandler()
+    {
+        subscriptions.for_each([](SubscriptionTable<>::SubscribeId, SubscriptionState& subscription) {
+            finish_group(subscription);
+            metrics().release_series(subscription.metricSeries);
+        });
+    }
+
+    /**
+     * @brief Subscriptions we issued to the peer on this connection
+     *
+     * Filled by subscribe(); incoming objects are matched with a single slab access.
+     */
+    SubscriptionTable<>& subscription_table()
+    {
+        return subscriptions;
+    }
+
+    /**
+     * @brief Subscribes to a track on the peer
+     * @return The subscribe ID the peer will put on every object of this subscription
+     *
+     * The ID is allocated from the connection's slab, so incoming objects are matched with a
+     * single slab access. The track name is interned once here, as on the publisher side.
+     */
+    SubscriptionTable<>::SubscribeId subscribe(const std::string& trackNamespace,
+                                               const std::string& trackName)
+    {
+        SubscriptionState subscription;
+        subscription.trackAlias = track_interner().intern(trackNamespace, trackName);
+        subscription.metricSeries = metrics().series(subscription.trackAlias, connectionId);
+        TrackAlias trackAlias = subscription.trackAlias;
+        SubscriptionTable<>::SubscribeId subscribeId = subscriptions.allocate(std::move(subscription));
+
+        protobuf_messages::MessageHeader subscribeHeader;
+        subscribeHeader.set_messagetype(protobuf_messages::MoQtMessageType::SUBSCRIBE);
+
+        protobuf_messages::SubscribeMessage subscribeMessage;
+        subscribeMessage.set_subscribeid(subscribeId);
+        subscribeMessage.set_trackalias(trackAlias);
+        subscribeMessage.set_tracknamespace(trackNamespace);
+        subscribeMessage.set_trackname(trackName);
+
+        QUIC_BUFFER* quicBuffer = serialization::serialize(subscribeHeader, subscribeMessage);
+        connectionState.enqueue_control_buffer(quicBuffer);
+
+        return subscribeId;
+    }
+
+    /**
+     * @brief Ends a subscription issued with subscribe()
+     * @return false if the ID is unknown or already ended
+     *
+     * Objects still in flight under the ID are dropped as stale.
+     */
+    bool unsubscribe(SubscriptionTable<>::SubscribeId subscribeId)
+    {
+        SubscriptionState* subscription = subscriptions.find(subscribeId);
+        if (subscription == nullptr)
+        {
+            return false;
+        }
+        finish_group(*subscription);
+        metrics().release_series(subscription->metricSeries);
+        subscriptions.release(subscribeId);
+
+        protobuf_messages::MessageHeader unsubscribeHeader;
+        unsubscribeHeader.set_messagetype(protobuf_messages::MoQtMessageType::UNSUBSCRIBE);
+
+        protobuf_messages::UnsubscribeMessage unsubscribeMessage;
+        unsubscribeMessage.set_subscribeid(subscribeId);
+
+        QUIC_BUFFER* quicBuffer = serialization::serialize(unsubscribeHeader, unsubscribeMessage);
+        connectionState.enqueue_control_buffer(quicBuffer);
+        return true;
+    }
+
+    /**
+     * @brief Number of subscriptions the peer currently holds with us
+     */
+    std::size_t peer_subscription_count() const
+    {
+        return peerSubscriptions.size();
+    }
+
+    /**
+     * @brief Sends GOAWAY if the relay started draining since this session last checked
+     * @return true if a GOAWAY was queued
+     *
+     * Runs on the connection's own thread: after every handled message, right after
+     * SERVER_SETUP, and from the session owner's timer for idle sessions. The drain controller
+     * never calls into the handler, so the control stream is only written from here.
+     */
+    bool poll_drain()
+    {
+        std::uint64_t epoch = drain_controller().drain_epoch();
+        if (!goAwayEligible || epoch == goAwayEpoch)
+        {
+            return false;
+        }
+        goAwayEpoch = epoch;
+        send_goaway();
+        return true;
+    }
+
+    /**
+     * @brief Sends GOAWAY with the drain controller's new session URI on the control stream
+     */
+    void send_goaway()
+    {
+        protobuf_messages::MessageHeader goAwayHeader;
+        goAwayHeader.set_messagetype(protobuf_messages::MoQtMessageType::GOAWAY);
+
+        protobuf_messages::GoAwayMessage goAwayMessage;
+        goAwayMessage.set_newsessionuri(drain_controller().goaway_uri());
+
+        QUIC_BUFFER* quicBuffer = serialization::serialize(goAwayHeader, goAwayMessage);
+        connectionState.enqueue_control_buffer(quicBuffer);
+    }
+
+    /**
+     * @brief Whether the peer sent GOAWAY, and where it asked us to reconnect
+     */
+    bool goaway_received() const
+    {
+        return goAwayReceived;
+    }
+
+    const std::string& goaway_uri() const
     {
+        return goAwayUri;
+    }
+
+    /**
+     * @brief How long to wait before reconnecting after the peer's GOAWAY
+     */
+    ReconnectPacer::Duration reconnect_delay() const
+    {
+        return reconnectDelay;
+    }
+
+    /**
+     * @brief Backoff for the session owner's reconnect attempts; after_failure() on refusals
+     */
+    ReconnectPacer& reconnect_pacer()
+    {
+        return reconnectPacer;
     }
 
     /**
@@ -163,14 +615,23 @@ public:
      * @param connectionState Current connection state
      * @param istream Input stream containing the serialized message
      * @return QUIC_STATUS indicating success or failure
+     *
+     * The message is parsed into this connection's cached MessageType object rather than a
+     * fresh one, reusing its allocated capacity. Handlers receive the cached object and copy
+     * out whatever they keep, so its buffers survive for the next parse.
      */
     template <typename MessageType>
     QUIC_STATUS handle_message(ConnectionState& connectionState,
                              google::protobuf::io::IstreamInputStream& istream)
     {
-        // Deserialize the message and forward to appropriate handler
-        MessageType message = serialization::deserialize<MessageType>(istream);
-        return handle_message(connectionState, std::move(message));
+        // Reparse into the cached message
+        MessageType& message = std::get<MessageType>(messageCache);
+        bool parsed = serialization::deserialize(istream, message);
+        utils::ASSERT_LOG_THROW(parsed, "Failed to deserialize message");
+
+        QUIC_STATUS status = handle_message(connectionState, std::move(message));
+        poll_drain();
+        return status;
     }
 };
 
@@ -0,0 +1,490 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <track_interner.hpp>
+
+namespace rvn
+{
+
+/**
+ * @brief Log-linear (HDR-style) latency histogram in microseconds
+ *
+ * Values are bucketed by power of two with subBuckets linear steps inside each power, so
+ * every recorded value is within 1 / subBuckets relative error. Each histogram has a single
+ * writer thread; the cells are atomics written with plain relaxed stores, so a concurrent
+ * scrape can read them without locks and the writer never pays for a read-modify-write.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr unsigned subBucketBits = 3;
+    static constexpr unsigned subBuckets = 1u << subBucketBits;
+    static constexpr unsigned magnitudes = 28; // Up to ~2^30 us (~18 minutes)
+    static constexpr unsigned bucketCount = magnitudes * subBuckets;
+
+private:
+    std::array<std::atomic<std::uint64_t>, bucketCount> buckets{};
+
+    static unsigned bucket_for(std::uint64_t micros)
+    {
+        if (micros < subBuckets)
+        {
+            return static_cast<unsigned>(micros);
+        }
+        unsigned magnitude = 63u - static_cast<unsigned>(__builtin_clzll(micros)); // >= subBucketBits
+        unsigned sub = static_cast<unsigned>(micros >> (magnitude - subBucketBits)) & (subBuckets - 1);
+        unsigned bucket = (magnitude - subBucketBits + 1) * subBuckets + sub;
+        return bucket < bucketCount ? bucket : bucketCount - 1;
+    }
+
+public:
+    /**
+     * @brief Lowest value that maps to a bucket (used when reporting quantiles)
+     */
+    static std::uint64_t bucket_floor(unsigned bucket)
+    {
+        if (bucket < subBuckets)
+        {
+            return bucket;
+        }
+        unsigned magnitude = bucket / subBuckets + subBucketBits - 1;
+        std::uint64_t sub = bucket % subBuckets;
+        return (std::uint64_t{1} << magnitude) | (sub << (magnitude - subBucketBits));
+    }
+
+    void record(std::uint64_t micros)
+    {
+        std::atomic<std::uint64_t>& cell = buckets[bucket_for(micros)];
+        cell.store(cell.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Adds this histogram's counts into a scrape accumulator
+     */
+    void add_to(std::array<std::uint64_t, bucketCount>& totals) const
+    {
+        for (unsigned i = 0; i < bucketCount; ++i)
+        {
+            totals[i] += buckets[i].load(std::memory_order_relaxed);
+        }
+    }
+};
+
+/**
+ * @brief Handle to one metric series (track alias, connection), resolved once at subscribe
+ *        time so the per-object path never hashes a key
+ */
+struct MetricSeries
+{
+    static constexpr std::uint32_t invalid = ~0u;
+    std::uint32_t index = invalid;
+
+    bool valid() const
+    {
+        return index != invalid;
+    }
+};
+
+/**
+ * @brief Per-track, per-connection metrics with lock-free per-thread recording
+ *
+ * Every recording thread owns a shard of cells indexed by series; counters are bumped with
+ * relaxed stores on thread-private cache lines, and latency histograms are allocated only
+ * for series that record latency. Queue depth is a gauge shared by all threads. Nothing
+ * is aggregated until dump() is called, so the cost when nobody scrapes is a few
+ * uncontended stores per object.
+ */
+class MetricsRegistry
+{
+public:
+    static constexpr std::uint32_t chunkBits = 10;
+    static constexpr std::uint32_t chunkSize = 1u << chunkBits;
+    static constexpr std::uint32_t maxChunks = 1024; // Up to ~1M series
+
+private:
+    struct alignas(64) Cell
+    {
+        std::atomic<std::uint64_t> objects{0};
+        std::atomic<std::uint64_t> bytes{0};
+        std::atomic<LatencyHistogram*> latency{nullptr};
+
+        ~Cell()
+        {
+            delete latency.load(std::memory_order_relaxed);
+        }
+
+        // Only while no thread records into the cell
+        void reset()
+        {
+            objects.store(0, std::memory_order_relaxed);
+            bytes.store(0, std::memory_order_relaxed);
+            delete latency.exchange(nullptr, std::memory_order_relaxed);
+        }
+    };
+
+    struct Chunk
+    {
+        Cell cells[chunkSize];
+    };
+
+    // Cells of one recording thread; chunks are published once and never move
+    struct Shard
+    {
+        std::array<std::atomic<Chunk*>, maxChunks> chunks{};
+
+        ~Shard()
+        {
+            for (auto& chunk : chunks)
+            {
+                delete chunk.load(std::memory_order_relaxed);
+            }
+        }
+
+        Cell& cell(std::uint32_t index)
+        {
+            std::atomic<Chunk*>& slot = chunks[index >> chunkBits];
+            Chunk* chunk = slot.load(std::memory_order_relaxed);
+            if (chunk == nullptr)
+            {
+                chunk = new Chunk();
+                slot.store(chunk, std::memory_order_release);
+            }
+            return chunk->cells[index & (chunkSize - 1)];
+        }
+
+        Cell* find(std::uint32_t index) const
+        {
+            Chunk* chunk = chunks[index >> chunkBits].load(std::memory_order_acquire);
+            return chunk ? &chunk->cells[index & (chunkSize - 1)] : nullptr;
+        }
+    };
+
+    struct SeriesKey
+    {
+        TrackAlias track;
+        std::uint64_t connection;
+
+        bool operator<(const SeriesKey& other) const
+        {
+            return track != other.track ? track < other.track : connection < other.connection;
+        }
+    };
+
+    mutable std::mutex mutex; // Guards registration and scraping, never recording
+    std::map<SeriesKey, std::uint32_t> seriesByKey;
+    std::vector<SeriesKey> keys;            // By series index
+    std::vector<bool> liveSeries;           // By series index; released slots are skipped
+    std::vector<std::uint32_t> freeSeries;  // Released indexes, reused before new ones
+    std::atomic<std::uint64_t> seriesDropped{0}; // series() calls refused at the cap
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::array<std::atomic<std::atomic<std::int64_t>*>, maxChunks> gaugeChunks{};
+    std::atomic<std::uint64_t> nextConnection{1};
+    const std::uint64_t registryId = next_registry_id();
+
+    static std::uint64_t next_registry_id()
+    {
+        static std::atomic<std::uint64_t> nextId{1};
+        return nextId.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Shard& local_shard()
+    {
+        // One shard per (registry, thread). Keyed by registry ID rather than address: a
+        // registry created where a destroyed one lived must not find the dead one's shard.
+        // Registries are long-lived, so this stays small.
+        thread_local std::vector<std::pair<std::uint64_t, Shard*>> owned;
+        for (auto& [id, shard] : owned)
+        {
+            if (id == registryId)
+            {
+                return *shard;
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        shards.push_back(std::make_unique<Shard>());
+        owned.emplace_back(registryId, shards.back().get());
+        return *shards.back();
+    }
+
+    /**
+     * @brief Writes a label value with backslash, double quote and newline escaped
+     */
+    static void write_label_value(std::ostream& out, std::string_view value)
+    {
+        for (char c : value)
+        {
+            switch (c)
+            {
+            case '\\':
+                out << "\\\\";
+                break;
+            case '"':
+                out << "\\\"";
+                break;
+            case '\n':
+                out << "\\n";
+                break;
+            default:
+                out << c;
+                break;
+            }
+        }
+    }
+
+    std::atomic<std::int64_t>& gauge(std::uint32_t index) const
+    {
+        return gaugeChunks[index >> chunkBits].load(std::memory_order_acquire)[index & (chunkSize - 1)];
+    }
+
+public:
+    MetricsRegistry() = default;
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    ~MetricsRegistry()
+    {
+        for (auto& chunk : gaugeChunks)
+        {
+            delete[] chunk.load(std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Unique ID for labelling a connection's series
+     */
+    std::uint64_t next_connection_id()
+    {
+        return nextConnection.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Resolves (or creates) the series for a track on a connection
+     *
+     * Once maxChunks * chunkSize series are live, new ones are refused: the returned handle is
+     * invalid, recording into it is a no-op, and the refusal is counted and exported as
+     * moqt_series_dropped_total.
+     */
+    MetricSeries series(TrackAlias track, std::uint64_t connection)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto iter = seriesByKey.find({track, connection});
+        if (iter != seriesByKey.end())
+        {
+            return {iter->second};
+        }
+
+        std::uint32_t index;
+        if (!freeSeries.empty())
+        {
+            index = freeSeries.back();
+            freeSeries.pop_back();
+            keys[index] = {track, connection};
+            liveSeries[index] = true;
+        }
+        else if (keys.size() < static_cast<std::size_t>(maxChunks) * chunkSize)
+        {
+            index = static_cast<std::uint32_t>(keys.size());
+            if (gaugeChunks[index >> chunkBits].load(std::memory_order_relaxed) == nullptr)
+            {
+                gaugeChunks[index >> chunkBits].store(new std::atomic<std::int64_t>[chunkSize](),
+                                                      std::memory_order_release);
+            }
+            keys.push_back({track, connection});
+            liveSeries.push_back(true);
+        }
+        else
+        {
+            seriesDropped.fetch_add(1, std::memory_order_relaxed);
+            return {};
+        }
+        seriesByKey.emplace(SeriesKey{track, connection}, index);
+        return {index};
+    }
+
+    /**
+     * @brief Ends a series when its subscription ends, so its slot can be reused
+     *
+     * Its counters are cleared and it is no longer exported. No thread may record into the
+     * series any more; a later series() for the same key starts from zero.
+     */
+    void release_series(MetricSeries series)
+    {
+        if (!series.valid())
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if (series.index >= keys.size() || !liveSeries[series.index])
+        {
+            return;
+        }
+        for (const auto& shard : shards)
+        {
+            if (Cell* cell = shard->find(series.index))
+            {
+                cell->reset();
+            }
+        }
+        gauge(series.index).store(0, std::memory_order_relaxed);
+        seriesByKey.erase(keys[series.index]);
+        liveSeries[series.index] = false;
+        freeSeries.push_back(series.index);
+    }
+
+    /**
+     * @brief Number of series() calls refused because the registry was full
+     */
+    std::uint64_t dropped_series() const
+    {
+        return seriesDropped.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Counts one object of the given size on this thread
+     */
+    void record_object(MetricSeries series, std::uint64_t bytes)
+    {
+        if (!series.valid())
+        {
+            return;
+        }
+        Cell& cell = local_shard().cell(series.index);
+        cell.objects.store(cell.objects.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        cell.bytes.store(cell.bytes.load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Records an end-to-end object latency (publish to delivery)
+     */
+    void record_latency(MetricSeries series, std::uint64_t micros)
+    {
+        if (!series.valid())
+        {
+            return;
+        }
+        Cell& cell = local_shard().cell(series.index);
+        LatencyHistogram* histogram = cell.latency.load(std::memory_order_relaxed);
+        if (histogram == nullptr)
+        {
+            histogram = new LatencyHistogram();
+            cell.latency.store(histogram, std::memory_order_release);
+        }
+        histogram->record(micros);
+    }
+
+    /**
+     * @brief Sets the current send/receive queue depth of a series
+     */
+    void set_queue_depth(MetricSeries series, std::int64_t depth)
+    {
+        if (series.valid())
+        {
+            gauge(series.index).store(depth, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Writes every series in Prometheus text exposition format
+     *
+     * Counters are running totals; objects/sec and bytes/sec are derived by the scraper from
+     * successive dumps. Latency is reported as quantiles of the merged histograms.
+     */
+    void dump(std::ostream& os, const TrackNameInterner& interner = track_interner()) const
+    {
+        static constexpr double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (std::uint32_t index = 0; index < keys.size(); ++index)
+        {
+            if (!liveSeries[index])
+            {
+                continue;
+            }
+            std::uint64_t objects = 0;
+            std::uint64_t bytes = 0;
+            std::array<std::uint64_t, LatencyHistogram::bucketCount> latency{};
+            bool haveLatency = false;
+            for (const auto& shard : shards)
+            {
+                if (const Cell* cell = shard->find(index))
+                {
+                    objects += cell->objects.load(std::memory_order_relaxed);
+                    bytes += cell->bytes.load(std::memory_order_relaxed);
+                    if (const LatencyHistogram* histogram =
+                            cell->latency.load(std::memory_order_acquire))
+                    {
+                        histogram->add_to(latency);
+                        haveLatency = true;
+                    }
+                }
+            }
+
+            const FullTrackName& name = interner.name_of(keys[index].track);
+            auto labels = [&](std::ostream& out) -> std::ostream& {
+                out << "{track=\"";
+                write_label_value(out, name.trackNamespace);
+                out << '/';
+                write_label_value(out, name.trackName);
+                return out << "\",connection=\"" << keys[index].connection << '"';
+            };
+            labels(os << "moqt_objects_total") << "} " << objects << '\n';
+            labels(os << "moqt_bytes_total") << "} " << bytes << '\n';
+            labels(os << "moqt_queue_depth") << "} "
+                << gauge(index).load(std::memory_order_relaxed) << '\n';
+
+            if (haveLatency)
+            {
+                std::uint64_t total = 0;
+                for (std::uint64_t count : latency)
+                {
+                    total += count;
+                }
+                // A histogram can be seen before its first count lands; with no counts there
+                // is no rank to look up
+                for (double quantile : quantiles)
+                {
+                    if (total == 0)
+                    {
+                        break;
+                    }
+                    std::uint64_t rank = static_cast<std::uint64_t>(quantile * (total - 1));
+                    std::uint64_t seen = 0;
+                    unsigned bucket = 0;
+                    for (; bucket < LatencyHistogram::bucketCount; ++bucket)
+                    {
+                        seen += latency[bucket];
+                        if (seen > rank)
+                        {
+                            break;
+                        }
+                    }
+                    labels(os << "moqt_object_latency_us") << ",quantile=\"" << quantile << "\"} "
+                        << LatencyHistogram::bucket_floor(bucket) << '\n';
+                }
+                labels(os << "moqt_object_latency_us_count") << "} " << total << '\n';
+            }
+        }
+        os << "moqt_series_dropped_total " << dropped_series() << '\n';
+    }
+};
+
+/**
+ * @brief Process-wide registry scraped by the admin endpoint
+ */
+inline MetricsRegistry& metrics()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+} // namespace rvn
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message_lite.h>
+
+namespace rvn
+{
+
+/**
+ * @brief Pre-serialized object message shared by every subscriber of a fan-out
+ *
+ * When one incoming object is forwarded to N subscribers, the copies differ only in the
+ * subscribe ID and track alias. Protobuf fields may appear in any order on the wire, so the
+ * message is split into:
+ *   - leading bytes shared by all copies (e.g. the serialized MessageHeader),
+ *   - a per-subscriber prefix: the message length varint followed by the subscribe ID and
+ *     track alias fields, built on the stack by make_prefix(),
+ *   - the remaining fields, encoded once, ending with the payload field's tag and length,
+ *   - the payload bytes themselves, referenced and never copied.
+ * gather() fills scatter-gather buffers in that order, so per-subscriber work is a handful
+ * of varint writes. The template and the payload must outlive every send that uses them.
+ */
+class ObjectHeaderTemplate
+{
+public:
+    static constexpr std::size_t maxPrefixSize = 48;
+    static constexpr std::size_t bufferCount = 4;
+
+    /**
+     * @brief Per-subscriber prefix, small enough to live in a send context
+     */
+    struct Prefix
+    {
+        std::uint8_t bytes[maxPrefixSize];
+        std::uint8_t size = 0;
+    };
+
+private:
+    std::string leading;          // Shared bytes sent before the message (may be empty)
+    std::string sharedFields;     // Encoded once: shared fields + payload tag and length
+    std::string_view payload;     // Referenced payload bytes
+    std::uint32_t subscribeIdTag; // Precomputed varint-field tags
+    std::uint32_t trackAliasTag;
+
+    static constexpr std::uint32_t wireTypeVarint = 0;
+    static constexpr std::uint32_t wireTypeLengthDelimited = 2;
+
+    static std::size_t varint_size(std::uint64_t value)
+    {
+        std::size_t size = 1;
+        while (value >= 0x80)
+        {
+            value >>= 7;
+            size++;
+        }
+        return size;
+    }
+
+    static std::uint8_t* write_varint(std::uint8_t* out, std::uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            *out++ = static_cast<std::uint8_t>(value | 0x80);
+            value >>= 7;
+        }
+        *out++ = static_cast<std::uint8_t>(value);
+        return out;
+    }
+
+    static void append_varint(std::string& out, std::uint64_t value)
+    {
+        std::uint8_t buffer[10];
+        std::uint8_t* end = write_varint(buffer, value);
+        out.append(reinterpret_cast<const char*>(buffer), end - buffer);
+    }
+
+public:
+    /**
+     * @brief Builds the shared part of an object message
+     * @param sharedMessage Object message with every shared field set and the subscribe ID,
+     *                      track alias and payload fields left empty
+     * @param subscribeIdField Field number of the subscribe ID (varint)
+     * @param trackAliasField Field number of the track alias (varint)
+     * @param payloadField Field number of the payload (bytes)
+     * @param payload Payload bytes, referenced rather than copied
+     * @param leadingBytes Shared bytes preceding the message on the wire
+     */
+    ObjectHeaderTemplate(const google::protobuf::MessageLite& sharedMessage,
+                         std::uint32_t subscribeIdField, std::uint32_t trackAliasField,
+                         std::uint32_t payloadField, std::string_view payload,
+                         std::string leadingBytes = {})
+        : leading(std::move(leadingBytes)), payload(payload),
+          subscribeIdTag((subscribeIdField << 3) | wireTypeVarint),
+          trackAliasTag((trackAliasField << 3) | wireTypeVarint)
+    {
+        sharedMessage.AppendToString(&sharedFields);
+        append_varint(sharedFields, (payloadField << 3) | wireTypeLengthDelimited);
+        append_varint(sharedFields, payload.size());
+    }
+
+    /**
+     * @brief Encodes the per-subscriber prefix (message length, subscribe ID, track alias)
+     */
+    Prefix make_prefix(std::uint64_t subscribeId, std::uint64_t trackAlias) const
+    {
+        std::size_t fieldsSize = varint_size(subscribeIdTag) + varint_size(subscribeId) +
+                                 varint_size(trackAliasTag) + varint_size(trackAlias);
+        std::size_t messageSize = fieldsSize + sharedFields.size() + payload.size();
+
+        Prefix prefix;
+        std::uint8_t* out = write_varint(prefix.bytes, messageSize);
+        out = write_varint(out, subscribeIdTag);
+        out = write_varint(out, subscribeId);
+        out = write_varint(out, trackAliasTag);
+        out = write_varint(out, trackAlias);
+        prefix.size = static_cast<std::uint8_t>(out - prefix.bytes);
+        return prefix;
+    }
+
+    /**
+     * @brief Fills scatter-gather buffers for one subscriber
+     * @tparam Buffer Any buffer descriptor with Length and Buffer members (e.g. QUIC_BUFFER)
+     * @param prefix Prefix from make_prefix(); must stay alive until the send completes
+     * @param out Array of at least bufferCount descriptors
+     * @return Number of descriptors used
+     */
+    template <typename Buffer> std::size_t gather(const Prefix& prefix, Buffer* out) const
+    {
+        std::size_t used = 0;
+        auto add = [&](const void* data, std::size_t size) {
+            if (size == 0)
+            {
+                return;
+            }
+            out[used].Length = static_cast<decltype(out[used].Length)>(size);
+            out[used].Buffer = reinterpret_cast<decltype(out[used].Buffer)>(const_cast<void*>(data));
+            used++;
+        };
+        add(leading.data(), leading.size());
+        add(prefix.bytes, prefix.size);
+        add(sharedFields.data(), sharedFields.size());
+        add(payload.data(), payload.size());
+        return used;
+    }
+
+    /**
+     * @brief Total bytes on the wire for one subscriber's copy
+     */
+    std::size_t wire_size(const Prefix& prefix) const
+    {
+        return leading.size() + prefix.size + sharedFields.size() + payload.size();
+    }
+};
+
+/**
+ * @brief Field number lookup by lowercase name, so templates follow the .proto definition
+ * @tparam Message Generated protobuf message type
+ * @return Field number, or 0 if the message has no such field
+ */
+template <typename Message> std::uint32_t field_number(const std::string& lowercaseName)
+{
+    const google::protobuf::FieldDescriptor* field =
+        Message::descriptor()->FindFieldByLowercaseName(lowercaseName);
+    return field ? static_cast<std::uint32_t>(field->number()) : 0;
+}
+
+} // namespace rvn
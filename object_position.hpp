@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+namespace rvn
+{
+
+/**
+ * @brief Position of an object within a track
+ */
+struct ObjectPosition
+{
+    std::uint64_t group = 0;
+    std::uint64_t object = 0;
+
+    bool operator<(const ObjectPosition& other) const
+    {
+        return group != other.group ? group < other.group : object < other.object;
+    }
+};
+
+} // namespace rvn
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+enum class Side : uint8_t { Bid, Ask };
+
+// One aggregated price level as seen by subscribers
+struct BookLevel {
+    double price;
+    double quantity;
+};
+
+// Top-N levels of both sides, best first
+struct BookDepth {
+    std::vector<BookLevel> bids;
+    std::vector<BookLevel> asks;
+};
+
+// Level-2 (market-by-price) order book for one instrument.
+// Each side is a contiguous array of levels sorted so that the best price sits at the back:
+// best bid/ask is O(1), and updates, which cluster near the top of book, only shift the few
+// levels above them. Prices are kept as integer ticks so level matching is exact; asks are
+// stored with negated ticks so both sides share one ordering. Prices off the instrument's
+// tick are rejected rather than rounded onto a neighbouring level.
+class OrderBook {
+private:
+    struct Level {
+        int64_t key; // ticks for bids, -ticks for asks; ascending, best at back
+        double quantity;
+    };
+
+    static constexpr std::size_t kLinearScanLevels = 8;
+    static constexpr double kTickTolerance = 1e-6; // In ticks; absorbs binary rounding of decimal prices
+
+    double tickSize_;
+    std::vector<Level> bids_;
+    std::vector<Level> asks_;
+
+    std::vector<Level>& levels(Side side) { return side == Side::Bid ? bids_ : asks_; }
+    const std::vector<Level>& levels(Side side) const { return side == Side::Bid ? bids_ : asks_; }
+
+    int64_t key_for(Side side, double price) const {
+        double exact = price / tickSize_;
+        int64_t ticks = std::llround(exact);
+        if (!(std::fabs(exact - static_cast<double>(ticks)) <= kTickTolerance)) {
+            throw std::invalid_argument("Price is not a multiple of the tick size");
+        }
+        return side == Side::Bid ? ticks : -ticks;
+    }
+
+    BookLevel to_book_level(Side side, const Level& level) const {
+        int64_t ticks = side == Side::Bid ? level.key : -level.key;
+        return {ticks * tickSize_, level.quantity};
+    }
+
+    // First level with key >= the given key; near the top of book a short backwards scan
+    // beats the binary search
+    static std::vector<Level>::iterator locate(std::vector<Level>& side, int64_t key) {
+        std::size_t scanned = 0;
+        auto it = side.end();
+        while (it != side.begin() && scanned < kLinearScanLevels) {
+            if ((it - 1)->key < key) {
+                return it;
+            }
+            --it;
+            ++scanned;
+        }
+        if (it == side.begin()) {
+            return it;
+        }
+        return std::lower_bound(side.begin(), it, key,
+                                [](const Level& level, int64_t k) { return level.key < k; });
+    }
+
+public:
+    explicit OrderBook(double tickSize = 0.01) : tickSize_(tickSize) {
+        if (!(tickSize > 0)) {
+            throw std::invalid_argument("Tick size must be positive");
+        }
+    }
+
+    double tick_size() const { return tickSize_; }
+
+    // Adds quantity at a price, creating the level if needed
+    void add(Side side, double price, double quantity) {
+        if (!(quantity > 0)) {
+            throw std::invalid_argument("Quantity must be positive");
+        }
+        std::vector<Level>& book = levels(side);
+        int64_t key = key_for(side, price);
+        auto it = locate(book, key);
+        if (it != book.end() && it->key == key) {
+            it->quantity += quantity;
+        } else {
+            book.insert(it, {key, quantity});
+        }
+    }
+
+    // Replaces the quantity at an existing level; a non-positive quantity removes it
+    void modify(Side side, double price, double quantity) {
+        std::vector<Level>& book = levels(side);
+        int64_t key = key_for(side, price);
+        auto it = locate(book, key);
+        if (it == book.end() || it->key != key) {
+            throw std::invalid_argument("Price level not in book");
+        }
+        if (quantity > 0) {
+            it->quantity = quantity;
+        } else {
+            book.erase(it);
+        }
+    }
+
+    void remove(Side side, double price) {
+        std::vector<Level>& book = levels(side);
+        int64_t key = key_for(side, price);
+        auto it = locate(book, key);
+        if (it == book.end() || it->key != key) {
+            throw std::invalid_argument("Price level not in book");
+        }
+        book.erase(it);
+    }
+
+    std::optional<BookLevel> best(Side side) const {
+        const std::vector<Level>& book = levels(side);
+        if (book.empty()) {
+            return std::nullopt;
+        }
+        return to_book_level(side, book.back());
+    }
+
+    BookDepth depth(std::size_t maxLevels) const {
+        BookDepth result;
+        for (Side side : {Side::Bid, Side::Ask}) {
+            const std::vector<Level>& book = levels(side);
+            std::vector<BookLevel>& out = side == Side::Bid ? result.bids : result.asks;
+            std::size_t count = std::min(maxLevels, book.size());
+            out.reserve(count);
+            for (auto it = book.rbegin(); it != book.rbegin() + count; ++it) {
+                out.push_back(to_book_level(side, *it));
+            }
+        }
+        return result;
+    }
+
+    std::size_t level_count(Side side) const { return levels(side).size(); }
+
+    void clear() {
+        bids_.clear();
+        asks_.clear();
+    }
+};
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Predicate a subscriber registers instead of polling get_data
+enum class TriggerKind : uint8_t {
+    AbsoluteMove, // |price - last delivered| > threshold
+    PercentMove,  // |price - last delivered| > threshold % of last delivered
+    Cross,        // price moves strictly across the threshold level, either direction
+};
+
+struct TriggerSpec {
+    TriggerKind kind;
+    double threshold;
+};
+
+// One fired trigger, queued for the subscriber that owns it
+struct Alert {
+    uint64_t triggerId;
+    uint64_t instrumentId;
+    double price;     // Price that fired the trigger
+    double reference; // Last delivered price (moves) or the level (crossings)
+};
+
+// Threshold triggers evaluated at the publisher on every price update.
+// Every armed trigger is reduced to an upper bound (fires when price > bound) and/or a lower
+// bound (fires when price < bound). Each instrument keeps its upper bounds sorted descending
+// and its lower bounds ascending, so the bounds a new price crosses are exactly the tail of
+// each array: an update pops the few that fire and never looks at the rest. Fired triggers
+// are re-armed around the new price. Bounds left behind by a trigger that fired on its
+// other side, or was cancelled, are skipped via a generation check and compacted lazily.
+// Instruments and subscribers are the publisher's dense indices; each instrument keeps its
+// external ID only to stamp it on alerts. Trigger IDs carry the slot's reuse count above the
+// slot index, so an ID stays dead once cancelled even after its slot is reused. At most
+// kMaxQueuedAlerts are queued per subscriber; beyond that the oldest are dropped.
+class TriggerIndex {
+public:
+    static constexpr std::size_t kMaxQueuedAlerts = 4096;
+
+private:
+    struct Trigger {
+        uint32_t subscriber;
+        uint32_t instrument;
+        TriggerSpec spec;
+        double reference;
+        uint32_t generation; // Bumped on every arm; bounds of older arms are stale
+        uint32_t reuse;      // Bumped on cancel; upper half of the trigger ID
+        bool active;
+        bool armed;
+    };
+
+    struct Bound {
+        double value;
+        uint32_t trigger;
+        uint32_t generation;
+    };
+
+    struct InstrumentTriggers {
+        std::vector<Bound> upper; // Descending; smallest bound at back
+        std::vector<Bound> lower; // Ascending; largest bound at back
+        std::vector<uint32_t> unarmed; // Registered before the first price
+        std::size_t staleBounds = 0;
+        double lastPrice = 0;
+        bool havePrice = false;
+        uint64_t instrumentId = 0;
+    };
+
+    std::vector<Trigger> triggers_;
+    std::vector<uint32_t> freeTriggers_;
+    std::vector<InstrumentTriggers> instruments_; // Per instrument index
+    std::vector<std::deque<Alert>> alerts_;       // Per subscriber index, oldest first
+    std::vector<uint32_t> fired_; // Scratch, reused across updates
+    uint64_t droppedAlerts_ = 0;
+
+    uint64_t trigger_id(uint32_t index) const {
+        return (static_cast<uint64_t>(triggers_[index].reuse) << 32) | index;
+    }
+
+    InstrumentTriggers& book_for(uint32_t instrument, uint64_t instrumentId) {
+        if (instrument >= instruments_.size()) {
+            instruments_.resize(instrument + 1);
+        }
+        InstrumentTriggers& book = instruments_[instrument];
+        book.instrumentId = instrumentId;
+        return book;
+    }
+
+    bool is_live(const Bound& bound) const {
+        const Trigger& trigger = triggers_[bound.trigger];
+        return trigger.active && trigger.generation == bound.generation;
+    }
+
+    static void insert_upper(std::vector<Bound>& upper, Bound bound) {
+        auto it = std::lower_bound(upper.begin(), upper.end(), bound.value,
+                                   [](const Bound& b, double v) { return b.value > v; });
+        upper.insert(it, bound);
+    }
+
+    static void insert_lower(std::vector<Bound>& lower, Bound bound) {
+        auto it = std::lower_bound(lower.begin(), lower.end(), bound.value,
+                                   [](const Bound& b, double v) { return b.value < v; });
+        lower.insert(it, bound);
+    }
+
+    // Arms a trigger around the current price; bumps the generation so older bounds go stale
+    void arm(InstrumentTriggers& book, uint32_t index, double price) {
+        Trigger& trigger = triggers_[index];
+        trigger.generation++;
+        trigger.armed = true;
+        switch (trigger.spec.kind) {
+        case TriggerKind::AbsoluteMove:
+        case TriggerKind::PercentMove: {
+            double band = trigger.spec.kind == TriggerKind::AbsoluteMove
+                              ? trigger.spec.threshold
+                              : std::fabs(price) * trigger.spec.threshold / 100.0;
+            trigger.reference = price;
+            insert_upper(book.upper, {price + band, index, trigger.generation});
+            insert_lower(book.lower, {price - band, index, trigger.generation});
+            book.staleBounds++; // One of the pair goes stale when the other fires
+            break;
+        }
+        case TriggerKind::Cross:
+            trigger.reference = trigger.spec.threshold;
+            if (price <= trigger.spec.threshold) {
+                insert_upper(book.upper, {trigger.spec.threshold, index, trigger.generation});
+            }
+            if (price >= trigger.spec.threshold) {
+                insert_lower(book.lower, {trigger.spec.threshold, index, trigger.generation});
+            }
+            if (price == trigger.spec.threshold) {
+                book.staleBounds++;
+            }
+            break;
+        }
+    }
+
+    void compact(InstrumentTriggers& book) {
+        auto stale = [this](const Bound& bound) { return !is_live(bound); };
+        book.upper.erase(std::remove_if(book.upper.begin(), book.upper.end(), stale), book.upper.end());
+        book.lower.erase(std::remove_if(book.lower.begin(), book.lower.end(), stale), book.lower.end());
+        book.staleBounds = 0;
+    }
+
+    // Drops an active trigger: its bounds go stale and its slot is freed for reuse
+    void retire(uint32_t index) {
+        Trigger& trigger = triggers_[index];
+        InstrumentTriggers& book = instruments_[trigger.instrument];
+        if (trigger.armed) {
+            // Its live bounds go stale; of a pair, one was already counted when it was armed
+            book.staleBounds++;
+        } else {
+            book.unarmed.erase(std::remove(book.unarmed.begin(), book.unarmed.end(), index),
+                               book.unarmed.end());
+        }
+        trigger.active = false;
+        trigger.armed = false;
+        trigger.generation++;
+        trigger.reuse++;
+        freeTriggers_.push_back(index);
+    }
+
+public:
+    // Registers a trigger; it is armed at the instrument's latest price, or at the next one
+    uint64_t add(uint32_t subscriber, uint32_t instrument, uint64_t instrumentId, TriggerSpec spec) {
+        if (!(spec.threshold >= 0) || (spec.kind != TriggerKind::Cross && spec.threshold == 0)) {
+            throw std::invalid_argument("Invalid trigger threshold");
+        }
+        uint32_t index;
+        if (!freeTriggers_.empty()) {
+            index = freeTriggers_.back();
+            freeTriggers_.pop_back();
+        } else {
+            index = static_cast<uint32_t>(triggers_.size());
+            triggers_.push_back({});
+        }
+        Trigger& trigger = triggers_[index];
+        trigger = {subscriber, instrument, spec, 0, trigger.generation, trigger.reuse, true, false};
+
+        InstrumentTriggers& book = book_for(instrument, instrumentId);
+        if (book.havePrice) {
+            arm(book, index, book.lastPrice);
+        } else {
+            book.unarmed.push_back(index);
+        }
+        return trigger_id(index);
+    }
+
+    // Removes a trigger owned by the subscriber; its queued alerts are kept
+    bool cancel(uint32_t subscriber, uint64_t triggerId) {
+        uint32_t index = static_cast<uint32_t>(triggerId);
+        if (index >= triggers_.size() || trigger_id(index) != triggerId) {
+            return false;
+        }
+        Trigger& trigger = triggers_[index];
+        if (!trigger.active || trigger.subscriber != subscriber) {
+            return false;
+        }
+        retire(index);
+        return true;
+    }
+
+    // Cancels every trigger the subscriber owns and discards its queued alerts
+    void remove_subscriber(uint32_t subscriber) {
+        for (uint32_t index = 0; index < triggers_.size(); ++index) {
+            if (triggers_[index].active && triggers_[index].subscriber == subscriber) {
+                retire(index);
+            }
+        }
+        if (subscriber < alerts_.size()) {
+            std::deque<Alert>().swap(alerts_[subscriber]);
+        }
+    }
+
+    // Evaluates the instrument's triggers against a new price
+    void on_price(uint32_t instrument, uint64_t instrumentId, double price) {
+        // Tracked for every instrument so a new trigger is armed at the current price
+        InstrumentTriggers& book = book_for(instrument, instrumentId);
+        book.lastPrice = price;
+        book.havePrice = true;
+        for (uint32_t index : book.unarmed) {
+            arm(book, index, price);
+        }
+        book.unarmed.clear();
+
+        fired_.clear();
+        while (!book.upper.empty() && book.upper.back().value < price) {
+            if (is_live(book.upper.back())) {
+                fired_.push_back(book.upper.back().trigger);
+            } else if (book.staleBounds > 0) {
+                book.staleBounds--;
+            }
+            book.upper.pop_back();
+        }
+        while (!book.lower.empty() && book.lower.back().value > price) {
+            if (is_live(book.lower.back())) {
+                fired_.push_back(book.lower.back().trigger);
+            } else if (book.staleBounds > 0) {
+                book.staleBounds--;
+            }
+            book.lower.pop_back();
+        }
+
+        for (uint32_t index : fired_) {
+            Trigger& trigger = triggers_[index];
+            if (trigger.subscriber >= alerts_.size()) {
+                alerts_.resize(trigger.subscriber + 1);
+            }
+            std::deque<Alert>& queue = alerts_[trigger.subscriber];
+            if (queue.size() == kMaxQueuedAlerts) {
+                queue.pop_front();
+                droppedAlerts_++;
+            }
+            queue.push_back({trigger_id(index), instrumentId, price, trigger.reference});
+            arm(book, index, price);
+        }
+
+        if (book.staleBounds > book.upper.size() / 2 + book.lower.size() / 2 + 16) {
+            compact(book);
+        }
+    }
+
+    // Hands over and clears the subscriber's queued alerts
+    std::vector<Alert> drain_alerts(uint32_t subscriber) {
+        std::vector<Alert> drained;
+        if (subscriber < alerts_.size()) {
+            std::deque<Alert>& queue = alerts_[subscriber];
+            drained.assign(queue.begin(), queue.end());
+            queue.clear();
+        }
+        return drained;
+    }
+
+    // Alerts discarded because a subscriber's queue was full
+    uint64_t dropped_alerts() const { return droppedAlerts_; }
+};
@@ -1,123 +1,524 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <iostream>
-#include <unordered_map>
-#include <unordered_set>
+#include <optional>
 #include <memory>
 #include <vector>
 #include <string>
 #include <cstdint>
 #include <stdexcept>
 
-// Data structure to hold instrument data
-struct InstrumentData {
-    uint64_t instrumentId;
-    double lastTradedPrice;
-    double extraData; // Bond yield or last day volume based on publisher type
-};
+#include "alloc_tracker.hpp"
+#include "dense_ids.hpp"
+#include "derived_instruments.hpp"
+#include "disruptor.hpp"
+#include "instrument_store.hpp"
+#include "order_book.hpp"
+#include "price_triggers.hpp"
+#include "subscriber_registry.hpp"
+#include "tick_archive.hpp"
+#include "top_movers.hpp"
+
+// Incremental level-2 book update
+enum class BookAction : uint8_t { Add, Modify, Delete };
 
 // Abstract class for Publisher
+// External 64-bit instrument and subscriber IDs are mapped to dense 32-bit indices on first
+// use; the store, books, archives, entitlement bitsets and the trigger, derived-instrument and
+// top-movers engines are all keyed by them.
 class Publisher {
 protected:
-    std::unordered_map<uint64_t, InstrumentData> data_;
-    std::unordered_map<uint64_t, std::unordered_set<uint64_t>> subscribers_;
+    DenseIdMap instrumentIds_;
+    DenseIdMap subscriberIds_;
+    InstrumentStore data_;                       // Row = instrument index
+    std::vector<DenseBitset> entitlements_;      // Per subscriber index, bit = instrument index
+    std::vector<std::optional<OrderBook>> books_; // Per instrument index
+    std::vector<double> tickSizes_;              // Per instrument index, 0 for the publisher default
+    std::vector<TickArchive> history_;           // Per instrument index
+    TriggerIndex triggers_;
+    DerivedEngine derived_;
+    TopMovers movers_;
+
+    // Throws if the instrument does not belong to this publisher
+    virtual void validate_instrument(uint64_t) const {}
+
+    // Whether extraData is a volume (ranked by the volume leaders list)
+    virtual bool extra_is_volume() const { return false; }
+
+    // Price increment of instruments without their own tick size
+    virtual double default_tick_size() const { return 0.01; }
+
+    bool is_entitled(uint32_t subscriber, uint32_t instrument) const {
+        return subscriber < entitlements_.size() && entitlements_[subscriber].test(instrument);
+    }
+
+    // Returns the instrument's index once the subscriber is known to be entitled to it
+    uint32_t authorize(uint64_t subscriberId, uint64_t instrumentId) const {
+        auto subscriber = subscriberIds_.find(subscriberId);
+        auto instrument = instrumentIds_.find(instrumentId);
+        if (!subscriber || !instrument || !is_entitled(*subscriber, *instrument)) {
+            throw std::runtime_error("Subscriber not authorized for this instrument");
+        }
+        return *instrument;
+    }
+
+    // Index of an instrument, growing the per-instrument arrays on first use
+    uint32_t instrument_index(uint64_t instrumentId) {
+        uint32_t instrument = instrumentIds_.intern(instrumentId);
+        if (instrument >= history_.size()) {
+            books_.resize(instrument + 1);
+            tickSizes_.resize(instrument + 1);
+            history_.resize(instrument + 1);
+        }
+        return instrument;
+    }
+
+    bool is_derived(uint64_t instrumentId) const {
+        auto instrument = instrumentIds_.find(instrumentId);
+        return instrument && derived_.is_derived(*instrument);
+    }
+
+    void publish(uint32_t instrument, double lastTradedPrice, double extraData) {
+        uint64_t instrumentId = instrumentIds_.external(instrument);
+        data_.upsert(instrument, instrumentId, lastTradedPrice, extraData);
+        triggers_.on_price(instrument, instrumentId, lastTradedPrice);
+        movers_.on_update(instrument, instrumentId, lastTradedPrice, extraData, extra_is_volume());
+
+        // Wall-clock microseconds, clamped so a clock step back never reorders the archive
+        TickArchive& archive = history_[instrument];
+        int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+                          std::chrono::system_clock::now().time_since_epoch()).count();
+        archive.append(std::max(now, archive.last_timestamp()), lastTradedPrice, extraData);
+    }
 
 public:
     virtual ~Publisher() = default;
 
     virtual void update_data(uint64_t instrumentId, double lastTradedPrice, double extraData) {
-        data_[instrumentId] = {instrumentId, lastTradedPrice, extraData};
+        if (is_derived(instrumentId)) {
+            throw std::invalid_argument("Derived instruments are computed, not updated");
+        }
+        uint32_t instrument = instrument_index(instrumentId);
+        publish(instrument, lastTradedPrice, extraData);
+        derived_.on_update(instrument, lastTradedPrice, extraData);
+    }
+
+    // Defines a spread, basket or index over this publisher's instruments (or earlier derived
+    // ones); it is published like any other instrument from the next end_cycle(). Raw legs must
+    // already have data.
+    void define_derived(uint64_t derivedId, const std::vector<DerivedLeg>& legs, double constant = 0) {
+        validate_instrument(derivedId);
+        auto existing = instrumentIds_.find(derivedId);
+        if (existing && data_.contains(*existing)) {
+            throw std::invalid_argument("Instrument ID already in use");
+        }
+        std::vector<IndexedLeg> indexed;
+        indexed.reserve(legs.size());
+        for (const DerivedLeg& leg : legs) {
+            validate_instrument(leg.instrumentId);
+            auto instrument = instrumentIds_.find(leg.instrumentId);
+            if (!instrument) {
+                throw std::invalid_argument("Unknown leg instrument");
+            }
+            indexed.push_back({*instrument, leg.weight});
+        }
+        derived_.define(instrument_index(derivedId), indexed, constant);
+    }
+
+    // Closes an ingest cycle: derived instruments whose legs moved are recomputed once each
+    void end_cycle() {
+        derived_.flush([this](uint32_t instrument, double price, double extra) {
+            publish(instrument, price, extra);
+        });
+    }
+
+    // Sets the price increment of one instrument's book; must precede its first book update
+    void define_tick_size(uint64_t instrumentId, double tickSize) {
+        validate_instrument(instrumentId);
+        if (!(tickSize > 0)) {
+            throw std::invalid_argument("Tick size must be positive");
+        }
+        uint32_t instrument = instrument_index(instrumentId);
+        if (books_[instrument]) {
+            throw std::invalid_argument("Instrument book already built with another tick size");
+        }
+        tickSizes_[instrument] = tickSize;
+    }
+
+    // Applies one add/modify/delete from the depth feed to the instrument's book
+    void update_book(uint64_t instrumentId, BookAction action, Side side, double price, double quantity = 0) {
+        validate_instrument(instrumentId);
+        uint32_t instrument = instrument_index(instrumentId);
+        std::optional<OrderBook>& slot = books_[instrument];
+        if (!slot) {
+            slot.emplace(tickSizes_[instrument] > 0 ? tickSizes_[instrument] : default_tick_size());
+        }
+        OrderBook& book = *slot;
+        switch (action) {
+        case BookAction::Add:
+            book.add(side, price, quantity);
+            break;
+        case BookAction::Modify:
+            book.modify(side, price, quantity);
+            break;
+        case BookAction::Delete:
+            book.remove(side, price);
+            break;
+        }
     }
 
     void subscribe(uint64_t subscriberId, uint64_t instrumentId) {
-        subscribers_[instrumentId].insert(subscriberId);
+        uint32_t instrument = instrument_index(instrumentId);
+        uint32_t subscriber = subscriberIds_.intern(subscriberId);
+        if (subscriber >= entitlements_.size()) {
+            entitlements_.resize(subscriber + 1);
+        }
+        entitlements_[subscriber].set(instrument);
     }
 
-    virtual InstrumentData get_data(uint64_t subscriberId, uint64_t instrumentId) {
-        if (subscribers_[instrumentId].find(subscriberId) == subscribers_[instrumentId].end()) {
-            throw std::runtime_error("Subscriber not authorized for this instrument");
+    // Forgets everything held for the subscriber: entitlements (raw and derived instruments),
+    // triggers and queued alerts. The dense index stays mapped, so a later session with the
+    // same ID starts from a clean slate.
+    void remove_subscriber(uint64_t subscriberId) {
+        auto subscriber = subscriberIds_.find(subscriberId);
+        if (!subscriber) {
+            return;
+        }
+        if (*subscriber < entitlements_.size()) {
+            entitlements_[*subscriber] = DenseBitset();
         }
-        if (data_.find(instrumentId) == data_.end()) {
+        triggers_.remove_subscriber(*subscriber);
+    }
+
+    virtual InstrumentData get_data(uint64_t subscriberId, uint64_t instrumentId) {
+        auto data = data_.find(authorize(subscriberId, instrumentId));
+        if (!data) {
             throw std::runtime_error("Instrument data not available");
         }
-        return data_[instrumentId];
+        return *data;
+    }
+
+    // Screener scan over every instrument the subscriber is authorized for
+    std::vector<InstrumentData> scan(uint64_t subscriberId, const ScanQuery& query) const {
+        auto subscriber = subscriberIds_.find(subscriberId);
+        if (!subscriber || *subscriber >= entitlements_.size()) {
+            return {};
+        }
+        const DenseBitset& entitled = entitlements_[*subscriber];
+        return data_.scan(query, [&entitled](uint32_t instrument) { return entitled.test(instrument); });
+    }
+
+    // Registers a server-side threshold trigger on an instrument the subscriber is authorized for
+    uint64_t add_trigger(uint64_t subscriberId, uint64_t instrumentId, TriggerSpec spec) {
+        uint32_t instrument = authorize(subscriberId, instrumentId);
+        return triggers_.add(*subscriberIds_.find(subscriberId), instrument, instrumentId, spec);
+    }
+
+    bool cancel_trigger(uint64_t subscriberId, uint64_t triggerId) {
+        auto subscriber = subscriberIds_.find(subscriberId);
+        return subscriber && triggers_.cancel(*subscriber, triggerId);
+    }
+
+    // Alerts fired since the subscriber's last call
+    std::vector<Alert> drain_alerts(uint64_t subscriberId) {
+        auto subscriber = subscriberIds_.find(subscriberId);
+        if (!subscriber) {
+            return {};
+        }
+        return triggers_.drain_alerts(*subscriber);
+    }
+
+    // Precomputed top gainers, losers or volume leaders, limited to instruments the subscriber
+    // is authorized for (so possibly shorter than the ranking's N)
+    std::vector<Mover> top_movers(uint64_t subscriberId, MoverRanking ranking) const {
+        std::vector<Mover> movers = movers_.top(ranking);
+        auto subscriber = subscriberIds_.find(subscriberId);
+        movers.erase(std::remove_if(movers.begin(), movers.end(),
+                                    [&](const Mover& mover) {
+                                        auto instrument = instrumentIds_.find(mover.instrumentId);
+                                        return !subscriber || !instrument || !is_entitled(*subscriber, *instrument);
+                                    }),
+                     movers.end());
+        return movers;
+    }
+
+    // Starts a new trading session: current prices become the percent-change references
+    void start_session() {
+        movers_.reset_session();
+    }
+
+    // Archived updates with from <= timestamp (us since epoch) <= to, under get_data's authorization
+    std::vector<TickRecord> get_history(uint64_t subscriberId, uint64_t instrumentId, int64_t from, int64_t to) {
+        return history_[authorize(subscriberId, instrumentId)].query(from, to);
+    }
+
+    // Top-N levels of the instrument's book, under the same authorization as get_data
+    virtual BookDepth get_depth(uint64_t subscriberId, uint64_t instrumentId, std::size_t levels) {
+        const std::optional<OrderBook>& book = books_[authorize(subscriberId, instrumentId)];
+        if (!book) {
+            throw std::runtime_error("Instrument book not available");
+        }
+        return book->depth(levels);
     }
 };
 
 // EquityPublisher class
 class EquityPublisher : public Publisher {
-public:
-    void update_data(uint64_t instrumentId, double lastTradedPrice, double lastDayVolume) override {
+protected:
+    bool extra_is_volume() const override { return true; }
+
+    void validate_instrument(uint64_t instrumentId) const override {
         if (instrumentId >= 1000) {
             throw std::invalid_argument("Invalid instrument ID for EquityPublisher");
         }
+    }
+
+public:
+    void update_data(uint64_t instrumentId, double lastTradedPrice, double lastDayVolume) override {
+        validate_instrument(instrumentId);
         Publisher::update_data(instrumentId, lastTradedPrice, lastDayVolume);
     }
 };
 
 // BondPublisher class
 class BondPublisher : public Publisher {
-public:
-    void update_data(uint64_t instrumentId, double lastTradedPrice, double bondYield) override {
+protected:
+    // Treasuries quote in 32nds
+    double default_tick_size() const override { return 1.0 / 32; }
+
+    void validate_instrument(uint64_t instrumentId) const override {
         if (instrumentId < 1000 || instrumentId >= 2000) {
             throw std::invalid_argument("Invalid instrument ID for BondPublisher");
         }
+    }
+
+public:
+    void update_data(uint64_t instrumentId, double lastTradedPrice, double bondYield) override {
+        validate_instrument(instrumentId);
         Publisher::update_data(instrumentId, lastTradedPrice, bondYield);
     }
 };
 
-// Abstract class for Subscriber
-class Subscriber {
-protected:
-    uint64_t id_;
+// Event carried through the ingest ring
+struct TickEvent {
+    uint64_t instrumentId;
+    double lastTradedPrice;
+    double extraData;
+    bool accepted; // Set by the store stage
+};
+
+// Disruptor-style ingest for one publisher. The feed thread claims a pre-allocated ring slot
+// per tick and moves on; each consumer runs on its own thread behind a sequence barrier:
+//   store   - applies the tick via update_data, closing a derived-instrument cycle at the end
+//             of every batch it drains
+//   journal - sees every raw tick, in parallel with the store
+//   fan-out - runs behind the store and sees only ticks the store accepted
+// A slow journal or fan-out only stalls ingestion once it falls a full ring behind. While the
+// pipeline runs, the publisher belongs to the store stage and must not be used elsewhere.
+// Each stage, and the feed thread when the ring is full, waits by its own WaitStrategy: a
+// latency-critical fan-out can busy-spin on a pinned core while a journal blocks on a futex.
+class IngestPipeline {
+public:
+    using TickHandler = std::function<void(const TickEvent&)>;
+
+    struct Waits {
+        WaitStrategy producer;
+        WaitStrategy store;
+        WaitStrategy journal;
+        WaitStrategy fanout;
+    };
+
+private:
+    RingBuffer<TickEvent> ring_;
+    WaitStrategy feedWait_; // How the feed thread waits, for a full ring or in stop()
+    Publisher& publisher_;
+    std::atomic<uint64_t> rejected_{0};
+    BatchStage<TickEvent> store_;
+    BatchStage<TickEvent> journal_;
+    BatchStage<TickEvent> fanout_;
+    int64_t lastPublished_ = -1;
+    bool running_ = false;
 
 public:
-    explicit Subscriber(uint64_t id) : id_(id) {}
-    virtual ~Subscriber() = default;
+    // Throws std::runtime_error if a stage's thread can't be pinned to the CPU its strategy names
+    IngestPipeline(Publisher& publisher, TickHandler journal, TickHandler fanout, Waits waits = {},
+                   std::size_t capacity = 65536)
+        : ring_(capacity, waits.producer), feedWait_(waits.producer), publisher_(publisher),
+          store_(ring_, {},
+                 [this](TickEvent& event, int64_t, bool endOfBatch) {
+                     try {
+                         publisher_.update_data(event.instrumentId, event.lastTradedPrice, event.extraData);
+                         event.accepted = true;
+                     } catch (const std::exception &e) {
+                         event.accepted = false;
+                         rejected_.fetch_add(1, std::memory_order_relaxed);
+                     }
+                     if (endOfBatch) {
+                         publisher_.end_cycle();
+                     }
+                 },
+                 waits.store),
+          journal_(ring_, {},
+                   [journal](TickEvent& event, int64_t, bool) {
+                       if (journal) {
+                           journal(event);
+                       }
+                   },
+                   waits.journal),
+          fanout_(ring_, {&store_.sequence()},
+                  [fanout](TickEvent& event, int64_t, bool) {
+                      if (event.accepted && fanout) {
+                          fanout(event);
+                      }
+                  },
+                  waits.fanout) {
+        ring_.add_gating(journal_.sequence());
+        ring_.add_gating(fanout_.sequence());
+        store_.start();
+        journal_.start();
+        fanout_.start();
+        running_ = true;
+    }
+
+    ~IngestPipeline() { stop(); }
 
-    virtual void subscribe(std::shared_ptr<Publisher> publisher, uint64_t instrumentId) {
-        publisher->subscribe(id_, instrumentId);
+    // Feed thread only
+    void ingest(uint64_t instrumentId, double lastTradedPrice, double extraData) {
+        int64_t sequence = ring_.claim();
+        ring_[sequence] = {instrumentId, lastTradedPrice, extraData, false};
+        ring_.publish(sequence);
+        lastPublished_ = sequence;
     }
 
-    virtual std::string get_data(std::shared_ptr<Publisher> publisher, uint64_t instrumentId) = 0;
+    // Waits for every ingested tick to pass all stages, then stops the stage threads
+    void stop() {
+        if (!running_) {
+            return;
+        }
+        store_.drain(lastPublished_, feedWait_);
+        journal_.drain(lastPublished_, feedWait_);
+        fanout_.drain(lastPublished_, feedWait_);
+        store_.halt();
+        journal_.halt();
+        fanout_.halt();
+        running_ = false;
+    }
+
+    uint64_t rejected() const { return rejected_.load(std::memory_order_relaxed); }
 };
 
-// FreeSubscriber class
-class FreeSubscriber : public Subscriber {
+// Formats depth levels as "B price qty, ..., A price qty, ..."
+inline std::string format_depth(const BookDepth& depth) {
+    std::string out;
+    for (const BookLevel& level : depth.bids) {
+        out += ", B " + std::to_string(level.price) + " " + std::to_string(level.quantity);
+    }
+    for (const BookLevel& level : depth.asks) {
+        out += ", A " + std::to_string(level.price) + " " + std::to_string(level.quantity);
+    }
+    return out;
+}
+
+// Subscriber sessions and the requests they issue. Sessions live in a struct-of-arrays
+// registry; tier behavior (response tag, request allowance) is looked up in kTierPolicies
+// instead of being dispatched through per-subscriber objects.
+class Subscribers {
 private:
-    int requestCount_ = 0;
-    static const int MAX_REQUESTS = 100;
+    SubscriberRegistry registry_;
+    std::vector<Publisher*> publishers_; // Every publisher a subscriber was attached to
 
-public:
-    explicit FreeSubscriber(uint64_t id) : Subscriber(id) {}
+    Publisher& attach(Publisher& publisher) {
+        if (std::find(publishers_.begin(), publishers_.end(), &publisher) == publishers_.end()) {
+            publishers_.push_back(&publisher);
+        }
+        return publisher;
+    }
+
+    uint32_t slot_of(uint64_t subscriberId) const {
+        auto slot = registry_.find(subscriberId);
+        if (!slot) {
+            throw std::invalid_argument("Unknown subscriber");
+        }
+        return *slot;
+    }
+
+    std::string prefix(uint32_t slot, uint64_t instrumentId) const {
+        return std::string(1, registry_.policy(slot).tag) + ", " + std::to_string(registry_.id(slot)) + ", " +
+               std::to_string(instrumentId);
+    }
 
-    std::string get_data(std::shared_ptr<Publisher> publisher, uint64_t instrumentId) override {
-        if (requestCount_ >= MAX_REQUESTS) {
-            return "F, " + std::to_string(id_) + ", " + std::to_string(instrumentId) + ", invalid_request";
+    // Every request that counts against the tier's allowance goes through here: fn runs only
+    // while quota remains, and the request is counted once fn succeeds
+    template <typename Fn> auto charged(uint32_t slot, Fn&& fn) {
+        if (!registry_.has_quota(slot)) {
+            throw std::runtime_error("Request allowance exhausted");
         }
+        auto result = fn();
+        registry_.count_request(slot);
+        return result;
+    }
 
+    // Runs a counted request; fn returns the response body
+    template <typename Fn> std::string counted_request(uint64_t subscriberId, uint64_t instrumentId, Fn&& fn) {
+        uint32_t slot = slot_of(subscriberId);
         try {
-            auto data = publisher->get_data(id_, instrumentId);
-            requestCount_++;
-            return "F, " + std::to_string(id_) + ", " + std::to_string(instrumentId) + ", " +
-                   std::to_string(data.lastTradedPrice) + ", " + std::to_string(data.extraData);
+            return prefix(slot, instrumentId) + charged(slot, fn);
         } catch (const std::exception &e) {
-            return "F, " + std::to_string(id_) + ", " + std::to_string(instrumentId) + ", invalid_request";
+            return prefix(slot, instrumentId) + ", invalid_request";
         }
     }
-};
 
-// PaidSubscriber class
-class PaidSubscriber : public Subscriber {
 public:
-    explicit PaidSubscriber(uint64_t id) : Subscriber(id) {}
+    void add(uint64_t subscriberId, SubscriberTier tier) {
+        registry_.add(subscriberId, tier);
+    }
 
-    std::string get_data(std::shared_ptr<Publisher> publisher, uint64_t instrumentId) override {
-        try {
-            auto data = publisher->get_data(id_, instrumentId);
-            return "P, " + std::to_string(id_) + ", " + std::to_string(instrumentId) + ", " +
-                   std::to_string(data.lastTradedPrice) + ", " + std::to_string(data.extraData);
-        } catch (const std::exception &e) {
-            return "P, " + std::to_string(id_) + ", " + std::to_string(instrumentId) + ", invalid_request";
+    // Ends the session and clears its subscriptions, triggers and alerts at every publisher
+    bool remove(uint64_t subscriberId) {
+        if (!registry_.remove(subscriberId)) {
+            return false;
+        }
+        for (Publisher* publisher : publishers_) {
+            publisher->remove_subscriber(subscriberId);
         }
+        return true;
+    }
+
+    void subscribe(Publisher& publisher, uint64_t subscriberId, uint64_t instrumentId) {
+        slot_of(subscriberId);
+        attach(publisher).subscribe(subscriberId, instrumentId);
+    }
+
+    // Alert-style clients register a trigger once and drain fired alerts instead of polling
+    uint64_t add_trigger(Publisher& publisher, uint64_t subscriberId, uint64_t instrumentId, TriggerSpec spec) {
+        slot_of(subscriberId);
+        return attach(publisher).add_trigger(subscriberId, instrumentId, spec);
+    }
+
+    std::vector<Alert> drain_alerts(Publisher& publisher, uint64_t subscriberId) {
+        slot_of(subscriberId);
+        return publisher.drain_alerts(subscriberId);
+    }
+
+    // One scan instead of a get_data per instrument; counts as one request against the allowance
+    std::vector<InstrumentData> scan(const Publisher& publisher, uint64_t subscriberId, const ScanQuery& query) {
+        return charged(slot_of(subscriberId), [&] { return publisher.scan(subscriberId, query); });
+    }
+
+    std::string get_data(Publisher& publisher, uint64_t subscriberId, uint64_t instrumentId) {
+        return counted_request(subscriberId, instrumentId, [&] {
+            auto data = publisher.get_data(subscriberId, instrumentId);
+            return ", " + std::to_string(data.lastTradedPrice) + ", " + std::to_string(data.extraData);
+        });
+    }
+
+    // Depth requests count against the same request allowance as get_data
+    std::string get_depth(Publisher& publisher, uint64_t subscriberId, uint64_t instrumentId, std::size_t levels) {
+        return counted_request(subscriberId, instrumentId, [&] {
+            return format_depth(publisher.get_depth(subscriberId, instrumentId, levels));
+        });
     }
 };
 
@@ -126,21 +527,107 @@ int main() {
     auto equityPublisher = std::make_shared<EquityPublisher>();
     auto bondPublisher = std::make_shared<BondPublisher>();
 
-    auto freeSubscriber = std::make_shared<FreeSubscriber>(1);
-    auto paidSubscriber = std::make_shared<PaidSubscriber>(2);
+    Subscribers subscribers;
+    subscribers.add(1, SubscriberTier::Free);
+    subscribers.add(2, SubscriberTier::Paid);
 
     // Updating data
     equityPublisher->update_data(500, 150.5, 1000);
     bondPublisher->update_data(1500, 98.7, 3.5);
 
     // Subscribing
-    freeSubscriber->subscribe(equityPublisher, 500);
-    paidSubscriber->subscribe(bondPublisher, 1500);
+    subscribers.subscribe(*equityPublisher, 1, 500);
+    subscribers.subscribe(*bondPublisher, 2, 1500);
 
     // Getting data
-    std::cout << freeSubscriber->get_data(equityPublisher, 500) << std::endl;
-    std::cout << paidSubscriber->get_data(bondPublisher, 1500) << std::endl;
-    std::cout << freeSubscriber->get_data(bondPublisher, 1500) << std::endl; // Invalid request
+    std::cout << subscribers.get_data(*equityPublisher, 1, 500) << std::endl;
+    std::cout << subscribers.get_data(*bondPublisher, 2, 1500) << std::endl;
+    std::cout << subscribers.get_data(*bondPublisher, 1, 1500) << std::endl; // Invalid request
+
+    // Depth of book
+    equityPublisher->update_book(500, BookAction::Add, Side::Bid, 150.4, 200);
+    equityPublisher->update_book(500, BookAction::Add, Side::Bid, 150.3, 500);
+    equityPublisher->update_book(500, BookAction::Add, Side::Ask, 150.6, 100);
+    equityPublisher->update_book(500, BookAction::Add, Side::Ask, 150.7, 300);
+    equityPublisher->update_book(500, BookAction::Modify, Side::Bid, 150.4, 250);
+    equityPublisher->update_book(500, BookAction::Delete, Side::Ask, 150.7);
+    std::cout << subscribers.get_depth(*equityPublisher, 1, 500, 5) << std::endl;
+    std::cout << subscribers.get_depth(*equityPublisher, 2, 500, 5) << std::endl; // Invalid request
+
+    // Derived instruments: a bond spread and an equity basket, recomputed once per ingest cycle
+    bondPublisher->update_data(1501, 97.9, 3.7);
+    bondPublisher->define_derived(1900, {{1500, 1.0}, {1501, -1.0}});
+    equityPublisher->update_data(501, 80.25, 2500);
+    equityPublisher->define_derived(900, {{500, 0.5}, {501, 0.5}});
+    equityPublisher->end_cycle();
+    bondPublisher->end_cycle();
+    subscribers.subscribe(*bondPublisher, 2, 1900);
+    std::cout << subscribers.get_data(*bondPublisher, 2, 1900) << std::endl;
+    bondPublisher->update_data(1500, 98.9, 3.45);
+    bondPublisher->update_data(1501, 97.8, 3.75);
+    bondPublisher->end_cycle();
+    std::cout << subscribers.get_data(*bondPublisher, 2, 1900) << std::endl;
+
+    // History of the bond spread since it was defined
+    std::cout << "P, 2, 1900, history " << bondPublisher->get_history(2, 1900, 0, INT64_MAX).size()
+              << " ticks" << std::endl;
+
+    // Screener: the subscriber's equities above 100, highest volume first
+    ScanQuery screen;
+    screen.minPrice = 100;
+    screen.sortBy = ScanField::Extra;
+    screen.limit = 10;
+    subscribers.subscribe(*equityPublisher, 1, 501);
+    subscribers.subscribe(*equityPublisher, 1, 900);
+    for (const InstrumentData& data : subscribers.scan(*equityPublisher, 1, screen)) {
+        std::cout << "F, 1, " << data.instrumentId << ", " << std::to_string(data.lastTradedPrice) << ", "
+                  << std::to_string(data.extraData) << std::endl;
+    }
+
+    // Threshold alerts: only moves beyond 1% and crossings of 152 are delivered
+    subscribers.add_trigger(*equityPublisher, 1, 500, {TriggerKind::PercentMove, 1.0});
+    subscribers.add_trigger(*equityPublisher, 1, 500, {TriggerKind::Cross, 152.0});
+    for (double price : {150.7, 151.2, 152.4, 152.6, 151.9}) {
+        equityPublisher->update_data(500, price, 1000);
+    }
+    for (const Alert& alert : subscribers.drain_alerts(*equityPublisher, 1)) {
+        std::cout << "F, 1, " << alert.instrumentId << ", alert " << alert.triggerId << ", "
+                  << std::to_string(alert.reference) << " -> " << std::to_string(alert.price) << std::endl;
+    }
+
+    // Top gainers among the subscriber's equities
+    for (const Mover& mover : equityPublisher->top_movers(1, MoverRanking::Gainers)) {
+        std::cout << "F, 1, " << mover.instrumentId << ", " << std::to_string(mover.value) << "%" << std::endl;
+    }
+
+    // Ingest pipeline: the feed thread only claims ring slots; store, journal and fan-out run
+    // on their own threads. The journal sleeps on a futex when idle; fan-out spins briefly first.
+    {
+        std::atomic<uint64_t> journaled{0};
+        std::atomic<uint64_t> delivered{0};
+        IngestPipeline::Waits waits;
+        waits.journal.kind = WaitKind::Blocking;
+        waits.fanout.kind = WaitKind::Adaptive;
+        IngestPipeline pipeline(
+            *equityPublisher, [&](const TickEvent&) { journaled.fetch_add(1, std::memory_order_relaxed); },
+            [&](const TickEvent&) { delivered.fetch_add(1, std::memory_order_relaxed); }, waits);
+        for (int tick = 0; tick < 100000; ++tick) {
+            pipeline.ingest(500 + tick % 3, 150.0 + (tick % 100) * 0.01, 1000 + tick);
+        }
+        pipeline.ingest(5000, 1.0, 1.0); // Outside the equity range: rejected by the store stage
+        pipeline.stop();
+        std::cout << "pipeline: " << journaled << " journaled, " << delivered << " delivered, "
+                  << pipeline.rejected() << " rejected" << std::endl;
+    }
+
+    // Publisher lookups are a hot path and must stay allocation-free
+    // (enforced when built with -DALLOC_TRACKING)
+    {
+        alloc_tracking::NoAllocationScope noAllocations;
+        equityPublisher->get_data(1, 500);
+        bondPublisher->get_data(2, 1500);
+    }
+    alloc_tracking::print_thread_report(std::cout, 3);
 
     return 0;
 }
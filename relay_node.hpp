@@ -0,0 +1,597 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <loopback_transport.hpp>
+#include <metrics.hpp>
+#include <segment_cache.hpp>
+#include <subscription_table.hpp>
+#include <track_interner.hpp>
+
+namespace rvn
+{
+
+namespace relay_wire
+{
+
+/**
+ * @brief Frame types exchanged between relay hops
+ *
+ * A compact relay-to-relay encoding: a type byte followed by varints and
+ * length-prefixed strings. Subscribe IDs are chosen by the downstream hop and
+ * echoed on every object, so each hop resolves objects with one slab lookup.
+ */
+enum class FrameType : std::uint8_t
+{
+    SUBSCRIBE = 1,   // subscribeId, startGroup, startObject, namespace, name
+    UNSUBSCRIBE = 2, // subscribeId
+    OBJECT = 3,      // subscribeId, group, object, payload
+};
+
+inline void put_varint(std::string& out, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+inline void put_string(std::string& out, std::string_view value)
+{
+    put_varint(out, value.size());
+    out.append(value);
+}
+
+/**
+ * @brief Sequential reader; any overrun marks the frame invalid instead of throwing
+ */
+struct Reader
+{
+    std::string_view data;
+    bool ok = true;
+
+    std::uint64_t varint()
+    {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (data.empty())
+            {
+                ok = false;
+                return 0;
+            }
+            std::uint8_t byte = static_cast<std::uint8_t>(data.front());
+            data.remove_prefix(1);
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return value;
+            }
+        }
+        ok = false;
+        return 0;
+    }
+
+    std::string_view string()
+    {
+        std::uint64_t size = varint();
+        if (!ok || size > data.size())
+        {
+            ok = false;
+            return {};
+        }
+        std::string_view value = data.substr(0, size);
+        data.remove_prefix(size);
+        return value;
+    }
+};
+
+} // namespace relay_wire
+
+/**
+ * @brief Node of a relay distribution tree: origin, intermediate relay or leaf subscriber
+ *
+ * - Aggregation: however many downstream sessions subscribe to a track, the node holds a
+ *   single subscription for it on its active upstream.
+ * - Continuity: every track keeps a small replay window of recent objects. A subscribe with
+ *   a start position is served from that window before joining the live flow. With a
+ *   SegmentCache attached, the whole DVR window (memory and disk) is served instead.
+ * - Failover: upstreams are added in preference order. fail_over() moves every aggregated
+ *   track to the next standby, resubscribing from just after the last forwarded object.
+ *   Objects at or before that position are dropped as duplicates, and objects from the old
+ *   upstream are rejected as stale by the subscription slab's generation check.
+ *   Delivery stays gap-free only if the standby can serve that resume position, i.e. it
+ *   already carries the track and still holds the objects in its replay window or cache. A
+ *   cold standby can only start the track at its own live edge; objects published in between
+ *   are not recovered.
+ *
+ * Objects forwarded and the send queue depth are recorded in metrics() per track and
+ * downstream connection.
+ *
+ * Single-threaded: all calls and receive callbacks must come from one thread (the
+ * LoopbackNetwork thread in simulations, the connection's worker thread otherwise).
+ */
+class RelayNode
+{
+public:
+    using ObjectHandler = std::function<void(TrackAlias, ObjectPosition, std::string_view)>;
+
+    struct Stats
+    {
+        std::uint64_t objectsReceived = 0;
+        std::uint64_t objectsForwarded = 0;
+        std::uint64_t duplicatesDropped = 0;
+        std::uint64_t staleDropped = 0;
+        std::uint64_t upstreamSubscribes = 0;
+        std::uint64_t failovers = 0;
+        std::uint64_t subscribesRejected = 0; // Reused or reserved downstream subscribe IDs
+    };
+
+private:
+    static constexpr StreamId controlStream = 0;
+
+    struct CachedObject
+    {
+        ObjectPosition position;
+        std::string payload;
+    };
+
+    struct Downstream
+    {
+        Transport* transport;
+        std::uint64_t subscribeId; // Chosen by the downstream hop
+        MetricSeries metricSeries; // (track, downstream connection)
+    };
+
+    struct TrackState
+    {
+        bool known = false;
+        bool localSubscriber = false;
+        bool upstreamSubscribed = false;
+        SubscriptionTable<>::SubscribeId upstreamSubscribeId = 0;
+        bool haveLast = false;
+        ObjectPosition last;            // Last object accepted on this track
+        std::vector<Downstream> downstreams;
+        std::deque<CachedObject> replay;
+    };
+
+    TrackNameInterner& interner;
+    std::size_t replayWindow;
+    std::vector<Transport*> upstreams;    // Preference order; upstreams[activeUpstream] is used
+    std::size_t activeUpstream = 0;
+    SubscriptionTable<> upstreamSubscriptions;
+    std::vector<TrackState> tracks;       // Indexed by TrackAlias
+    ObjectHandler objectHandler;
+    SegmentCache* cache = nullptr;        // Optional DVR tier
+    Stats stats;
+
+    TrackState& track(TrackAlias alias)
+    {
+        if (alias >= tracks.size())
+        {
+            tracks.resize(alias + 1);
+        }
+        tracks[alias].known = true;
+        return tracks[alias];
+    }
+
+    bool has_interest(const TrackState& state) const
+    {
+        return state.localSubscriber || !state.downstreams.empty();
+    }
+
+    static StreamId object_stream(std::uint64_t subscribeId)
+    {
+        return subscribeId + 1; // One long-lived stream per subscription, after control
+    }
+
+    static std::string encode_object(std::uint64_t subscribeId, ObjectPosition position,
+                                     std::string_view payload)
+    {
+        std::string frame;
+        frame.reserve(payload.size() + 32);
+        frame.push_back(static_cast<char>(relay_wire::FrameType::OBJECT));
+        relay_wire::put_varint(frame, subscribeId);
+        relay_wire::put_varint(frame, position.group);
+        relay_wire::put_varint(frame, position.object);
+        relay_wire::put_string(frame, payload);
+        return frame;
+    }
+
+    /**
+     * @brief Sends one object to a downstream subscription and records it with the send
+     *        queue depth it left behind
+     */
+    void forward(const Downstream& downstream, ObjectPosition position, std::string_view payload)
+    {
+        downstream.transport->send(object_stream(downstream.subscribeId),
+                                   encode_object(downstream.subscribeId, position, payload));
+        stats.objectsForwarded++;
+        metrics().record_object(downstream.metricSeries, payload.size());
+        metrics().set_queue_depth(downstream.metricSeries,
+                                  static_cast<std::int64_t>(downstream.transport->queued()));
+    }
+
+    void subscribe_upstream(TrackAlias alias, TrackState& state)
+    {
+        if (upstreams.empty() || state.upstreamSubscribed)
+        {
+            return;
+        }
+
+        ObjectPosition start;
+        if (state.haveLast)
+        {
+            start = {state.last.group, state.last.object + 1};
+        }
+
+        SubscriptionState subscription;
+        subscription.trackAlias = alias;
+        state.upstreamSubscribeId = upstreamSubscriptions.allocate(subscription);
+        state.upstreamSubscribed = true;
+
+        const FullTrackName& name = interner.name_of(alias);
+        std::string frame;
+        frame.push_back(static_cast<char>(relay_wire::FrameType::SUBSCRIBE));
+        relay_wire::put_varint(frame, state.upstreamSubscribeId);
+        relay_wire::put_varint(frame, start.group);
+        relay_wire::put_varint(frame, start.object);
+        relay_wire::put_string(frame, name.trackNamespace);
+        relay_wire::put_string(frame, name.trackName);
+        upstreams[activeUpstream]->send(controlStream, std::move(frame));
+        stats.upstreamSubscribes++;
+    }
+
+    void unsubscribe_upstream(TrackState& state)
+    {
+        if (!state.upstreamSubscribed)
+        {
+            return;
+        }
+        std::string frame;
+        frame.push_back(static_cast<char>(relay_wire::FrameType::UNSUBSCRIBE));
+        relay_wire::put_varint(frame, state.upstreamSubscribeId);
+        upstreams[activeUpstream]->send(controlStream, std::move(frame));
+        upstreamSubscriptions.release(state.upstreamSubscribeId);
+        state.upstreamSubscribed = false;
+    }
+
+    /**
+     * @brief Accepts an object for a track and forwards it everywhere it is wanted
+     */
+    void accept_object(TrackAlias alias, ObjectPosition position, std::string_view payload)
+    {
+        TrackState& state = track(alias);
+        if (state.haveLast && !(state.last < position))
+        {
+            stats.duplicatesDropped++;
+            return;
+        }
+        state.last = position;
+        state.haveLast = true;
+
+        if (cache)
+        {
+            cache->put(alias, position, payload);
+        }
+        else if (replayWindow > 0)
+        {
+            if (state.replay.size() == replayWindow)
+            {
+                state.replay.pop_front();
+            }
+            state.replay.push_back({position, std::string(payload)});
+        }
+
+        for (const Downstream& downstream : state.downstreams)
+        {
+            forward(downstream, position, payload);
+        }
+        if (state.localSubscriber && objectHandler)
+        {
+            objectHandler(alias, position, payload);
+        }
+    }
+
+    void on_upstream_frame(std::size_t upstreamIndex, std::string_view bytes)
+    {
+        relay_wire::Reader reader{bytes};
+        if (bytes.empty() ||
+            static_cast<relay_wire::FrameType>(bytes.front()) != relay_wire::FrameType::OBJECT)
+        {
+            return;
+        }
+        reader.data.remove_prefix(1);
+        std::uint64_t subscribeId = reader.varint();
+        ObjectPosition position{reader.varint(), reader.varint()};
+        std::string_view payload = reader.string();
+        if (!reader.ok)
+        {
+            return;
+        }
+
+        stats.objectsReceived++;
+        const SubscriptionState* subscription = upstreamSubscriptions.find(subscribeId);
+        if (upstreamIndex != activeUpstream || subscription == nullptr)
+        {
+            stats.staleDropped++;
+            return;
+        }
+        accept_object(subscription->trackAlias, position, payload);
+    }
+
+    void on_downstream_frame(Transport* downstream, std::uint64_t connectionId,
+                             std::string_view bytes)
+    {
+        if (bytes.empty())
+        {
+            return;
+        }
+        relay_wire::Reader reader{bytes.substr(1)};
+        switch (static_cast<relay_wire::FrameType>(bytes.front()))
+        {
+        case relay_wire::FrameType::SUBSCRIBE:
+        {
+            std::uint64_t subscribeId = reader.varint();
+            ObjectPosition start{reader.varint(), reader.varint()};
+            std::string_view trackNamespace = reader.string();
+            std::string_view trackName = reader.string();
+            if (reader.ok)
+            {
+                add_downstream_subscription(downstream, connectionId, subscribeId, start,
+                                            trackNamespace, trackName);
+            }
+            break;
+        }
+        case relay_wire::FrameType::UNSUBSCRIBE:
+        {
+            std::uint64_t subscribeId = reader.varint();
+            if (reader.ok)
+            {
+                remove_downstream_subscription(downstream, subscribeId);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    bool has_downstream_subscription(const Transport* downstream, std::uint64_t subscribeId) const
+    {
+        for (const TrackState& state : tracks)
+        {
+            for (const Downstream& subscription : state.downstreams)
+            {
+                if (subscription.transport == downstream && subscription.subscribeId == subscribeId)
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void add_downstream_subscription(Transport* downstream, std::uint64_t connectionId,
+                                     std::uint64_t subscribeId, ObjectPosition start,
+                                     std::string_view trackNamespace, std::string_view trackName)
+    {
+        // A session's subscribe IDs must be unique so its objects and UNSUBSCRIBEs are
+        // unambiguous, and the largest ID is reserved: object_stream() would wrap it onto the
+        // control stream
+        if (subscribeId == std::numeric_limits<std::uint64_t>::max() ||
+            has_downstream_subscription(downstream, subscribeId))
+        {
+            stats.subscribesRejected++;
+            return;
+        }
+
+        TrackAlias alias = interner.intern(trackNamespace, trackName);
+        TrackState& state = track(alias);
+        Downstream subscription{downstream, subscribeId, metrics().series(alias, connectionId)};
+
+        // Catch the new subscriber up, then join the live flow. A cache attached mid-stream
+        // only holds objects accepted since, while the replay window holds the older ones, so
+        // the two are merged by position and a position held by both is sent once.
+        auto replay = state.replay.begin();
+        while (replay != state.replay.end() && replay->position < start)
+        {
+            ++replay;
+        }
+        if (cache && state.haveLast)
+        {
+            ObjectPosition end{state.last.group, state.last.object + 1};
+            cache->for_range(alias, start, end, [&](ObjectPosition position, std::string_view payload) {
+                for (; replay != state.replay.end() && replay->position < position; ++replay)
+                {
+                    forward(subscription, replay->position, replay->payload);
+                }
+                if (replay != state.replay.end() && !(position < replay->position))
+                {
+                    ++replay; // Same position as the cached copy
+                }
+                forward(subscription, position, payload);
+            });
+        }
+        for (; replay != state.replay.end(); ++replay)
+        {
+            forward(subscription, replay->position, replay->payload);
+        }
+        state.downstreams.push_back(subscription);
+        subscribe_upstream(alias, state);
+    }
+
+    /**
+     * @brief Drops one downstream subscription, or every subscription of the session if
+     *        allSubscriptions is set; upstream subscriptions nobody needs any more are ended
+     *
+     * The dropped subscriptions' metric series are released.
+     */
+    void remove_downstream_subscription(Transport* downstream, std::uint64_t subscribeId,
+                                        bool allSubscriptions = false)
+    {
+        for (TrackState& state : tracks)
+        {
+            auto& list = state.downstreams;
+            for (std::size_t i = 0; i < list.size();)
+            {
+                if (list[i].transport == downstream &&
+                    (allSubscriptions || list[i].subscribeId == subscribeId))
+                {
+                    metrics().release_series(list[i].metricSeries);
+                    list[i] = list.back();
+                    list.pop_back();
+                    if (!has_interest(state))
+                    {
+                        unsubscribe_upstream(state);
+                    }
+                    if (!allSubscriptions)
+                    {
+                        return;
+                    }
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+        }
+    }
+
+public:
+    /**
+     * @brief Constructor for RelayNode
+     * @param replayWindow Recent objects kept per track for catch-up and failover
+     * @param interner Track name interner (process-wide by default)
+     */
+    explicit RelayNode(std::size_t replayWindow = 256,
+                       TrackNameInterner& interner = track_interner())
+        : interner(interner), replayWindow(replayWindow)
+    {
+    }
+
+    RelayNode(const RelayNode&) = delete;
+    RelayNode& operator=(const RelayNode&) = delete;
+
+    /**
+     * @brief Adds an upstream; the first one added is primary, later ones are standbys
+     */
+    void add_upstream(Transport* upstream)
+    {
+        std::size_t index = upstreams.size();
+        upstreams.push_back(upstream);
+        upstream->set_receive_handler([this, index](StreamId, std::string_view bytes) {
+            on_upstream_frame(index, bytes);
+        });
+    }
+
+    /**
+     * @brief Accepts a downstream session (a viewer or a lower-tier relay)
+     */
+    void add_downstream(Transport* downstream)
+    {
+        std::uint64_t connectionId = metrics().next_connection_id();
+        downstream->set_receive_handler(
+            [this, downstream, connectionId](StreamId, std::string_view bytes) {
+                on_downstream_frame(downstream, connectionId, bytes);
+            });
+    }
+
+    /**
+     * @brief Forgets a downstream session that disconnected
+     *
+     * Every subscription it held is dropped (ending upstream subscriptions nobody else needs)
+     * and its receive handler is cleared, so the node keeps no pointer to the transport. Call
+     * before the transport is destroyed.
+     */
+    void remove_downstream(Transport* downstream)
+    {
+        remove_downstream_subscription(downstream, 0, true);
+        downstream->set_receive_handler(nullptr);
+    }
+
+    /**
+     * @brief Switches all aggregated subscriptions to the next standby upstream
+     * @return false if there is no standby left
+     */
+    bool fail_over()
+    {
+        if (activeUpstream + 1 >= upstreams.size())
+        {
+            return false;
+        }
+
+        // Old subscribe IDs become stale, so late objects from the failed upstream are dropped.
+        // The UNSUBSCRIBE is harmless if that upstream is gone and frees it if it is not.
+        for (TrackState& state : tracks)
+        {
+            unsubscribe_upstream(state);
+        }
+
+        activeUpstream++;
+        stats.failovers++;
+        for (TrackAlias alias = 0; alias < tracks.size(); ++alias)
+        {
+            if (tracks[alias].known && has_interest(tracks[alias]))
+            {
+                subscribe_upstream(alias, tracks[alias]);
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Subscribes this node itself (leaf viewer); objects go to the object handler
+     */
+    TrackAlias subscribe(std::string_view trackNamespace, std::string_view trackName)
+    {
+        TrackAlias alias = interner.intern(trackNamespace, trackName);
+        TrackState& state = track(alias);
+        state.localSubscriber = true;
+        subscribe_upstream(alias, state);
+        return alias;
+    }
+
+    /**
+     * @brief Attaches a DVR cache; it replaces the in-memory replay window for catch-up
+     */
+    void set_cache(SegmentCache* segmentCache)
+    {
+        cache = segmentCache;
+    }
+
+    void set_object_handler(ObjectHandler handler)
+    {
+        objectHandler = std::move(handler);
+    }
+
+    /**
+     * @brief Publishes an object at this node (origin role)
+     */
+    void publish(std::string_view trackNamespace, std::string_view trackName,
+                 ObjectPosition position, std::string_view payload)
+    {
+        accept_object(interner.intern(trackNamespace, trackName), position, payload);
+    }
+
+    const Stats& relay_stats() const
+    {
+        return stats;
+    }
+
+    std::size_t upstream_subscription_count() const
+    {
+        return upstreamSubscriptions.size();
+    }
+};
+
+} // namespace rvn
@@ -0,0 +1,485 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <object_position.hpp>
+#include <track_interner.hpp>
+
+namespace rvn
+{
+
+/**
+ * @brief Two-tier object cache for DVR / time-shift: recent groups in memory, cold groups
+ *        spilled to append-only segment files
+ *
+ * When the in-memory tier exceeds its budget, the oldest groups are written to the
+ * active segment file with a single pwrite per group. A compact per-track index maps
+ * (group, object) to (segment, offset, length). Reads of sealed segments go through a
+ * read-only mmap, the active segment is read with pread, and locate() hands out
+ * (fd, offset, length) so senders can use sendfile/splice straight from the page cache.
+ * Whole segments are deleted, oldest first, once the disk budget is exceeded.
+ *
+ * Single-threaded, like the relay node that owns it.
+ */
+class SegmentCache
+{
+public:
+    struct Options
+    {
+        std::string directory;                          // Must exist and be writable
+        std::size_t memoryBudgetBytes = 64ull << 20;    // In-memory tier size before spilling
+        std::size_t segmentBytes = 256ull << 20;        // Seal a segment beyond this size
+        std::size_t diskBudgetBytes = 64ull << 30;      // Delete oldest segments beyond this
+    };
+
+    /**
+     * @brief Location of a spilled object, usable with sendfile()/splice()
+     */
+    struct DiskSlice
+    {
+        int fd;
+        off_t offset;
+        std::size_t length;
+    };
+
+    struct Stats
+    {
+        std::size_t memoryBytes = 0;
+        std::size_t diskBytes = 0;
+        std::size_t segments = 0;
+        std::uint64_t groupsSpilled = 0;
+        std::uint64_t segmentsDropped = 0;
+    };
+
+private:
+    using GroupKey = std::pair<TrackAlias, std::uint64_t>;
+
+    struct HotGroup
+    {
+        std::vector<std::pair<std::uint64_t, std::string>> objects; // Sorted by object ID
+        std::size_t bytes = 0;
+    };
+
+    // 32-byte index entry; entries of a track are kept sorted by (group, object)
+    struct IndexEntry
+    {
+        std::uint64_t group;
+        std::uint64_t object;
+        std::uint32_t segment; // Segment sequence number
+        std::uint32_t length;
+        std::uint64_t offset;  // Offset of the payload within the segment
+    };
+    static_assert(sizeof(IndexEntry) == 32, "IndexEntry layout changed");
+
+    struct Segment
+    {
+        std::uint32_t sequence;
+        int fd = -1;
+        std::size_t size = 0;
+        bool sealed = false;
+        const char* mapping = nullptr; // Read-only mapping once sealed and first read
+    };
+
+    // On-disk record header preceding every payload, so segments can be re-indexed offline
+    struct RecordHeader
+    {
+        std::uint32_t track;
+        std::uint32_t length;
+        std::uint64_t group;
+        std::uint64_t object;
+    };
+
+    Options options;
+    std::map<GroupKey, HotGroup> hotGroups;
+    std::deque<GroupKey> hotOrder; // Spill order, oldest first
+    std::unordered_map<TrackAlias, std::vector<IndexEntry>> index;
+    std::deque<Segment> segments;  // Oldest first; back() is the active segment
+    std::uint32_t nextSegment = 0;
+    Stats stats;
+
+    static bool before(const IndexEntry& entry, ObjectPosition position)
+    {
+        return ObjectPosition{entry.group, entry.object} < position;
+    }
+
+    std::string segment_path(std::uint32_t sequence) const
+    {
+        return options.directory + "/segment-" + std::to_string(sequence) + ".dat";
+    }
+
+    static void throw_errno(const char* what)
+    {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    Segment& active_segment()
+    {
+        if (segments.empty() || segments.back().sealed)
+        {
+            Segment segment;
+            segment.sequence = nextSegment++;
+            segment.fd = ::open(segment_path(segment.sequence).c_str(),
+                                O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (segment.fd < 0)
+            {
+                throw_errno("SegmentCache: cannot create segment");
+            }
+            segments.push_back(segment);
+            stats.segments++;
+        }
+        return segments.back();
+    }
+
+    Segment* find_segment(std::uint32_t sequence) const
+    {
+        if (segments.empty() || sequence < segments.front().sequence)
+        {
+            return nullptr;
+        }
+        std::size_t position = sequence - segments.front().sequence;
+        return position < segments.size() ? const_cast<Segment*>(&segments[position]) : nullptr;
+    }
+
+    void spill_oldest_group()
+    {
+        GroupKey key = hotOrder.front();
+        auto iter = hotGroups.find(key);
+        HotGroup& group = iter->second;
+
+        Segment& segment = active_segment();
+
+        // Serialize the whole group and write it with one pwrite
+        std::string buffer;
+        std::vector<IndexEntry> spilled;
+        buffer.reserve(group.bytes + group.objects.size() * sizeof(RecordHeader));
+        spilled.reserve(group.objects.size());
+        for (auto& [objectId, payload] : group.objects)
+        {
+            RecordHeader header{key.first, static_cast<std::uint32_t>(payload.size()),
+                                key.second, objectId};
+            buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+            spilled.push_back({key.second, objectId, segment.sequence,
+                               static_cast<std::uint32_t>(payload.size()),
+                               segment.size + buffer.size()});
+            buffer.append(payload);
+        }
+
+        const char* data = buffer.data();
+        std::size_t remaining = buffer.size();
+        off_t offset = static_cast<off_t>(segment.size);
+        while (remaining > 0)
+        {
+            ssize_t written = ::pwrite(segment.fd, data, remaining, offset);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw_errno("SegmentCache: segment write failed");
+            }
+            data += written;
+            offset += written;
+            remaining -= static_cast<std::size_t>(written);
+        }
+
+        // Only now that the bytes are on disk may the index point at them and the hot copy go.
+        // A failed write above leaves the group hot and the index untouched.
+        std::vector<IndexEntry>& entries = index[key.first];
+        for (const IndexEntry& entry : spilled)
+        {
+            auto position = std::lower_bound(entries.begin(), entries.end(),
+                                             ObjectPosition{entry.group, entry.object}, before);
+            entries.insert(position, entry);
+        }
+
+        segment.size += buffer.size();
+        stats.diskBytes += buffer.size();
+        stats.memoryBytes -= group.bytes;
+        stats.groupsSpilled++;
+        hotOrder.pop_front();
+        hotGroups.erase(iter);
+
+        if (segment.size >= options.segmentBytes)
+        {
+            segment.sealed = true;
+        }
+        enforce_disk_budget();
+    }
+
+    void drop_oldest_segment()
+    {
+        Segment& segment = segments.front();
+        if (segment.mapping)
+        {
+            ::munmap(const_cast<char*>(segment.mapping), segment.size);
+        }
+        ::close(segment.fd);
+        ::unlink(segment_path(segment.sequence).c_str());
+
+        for (auto& [track, entries] : index)
+        {
+            std::uint32_t sequence = segment.sequence;
+            entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                         [sequence](const IndexEntry& entry) {
+                                             return entry.segment == sequence;
+                                         }),
+                          entries.end());
+        }
+
+        stats.diskBytes -= segment.size;
+        stats.segments--;
+        stats.segmentsDropped++;
+        segments.pop_front();
+    }
+
+    void enforce_disk_budget()
+    {
+        // Never drop the segment currently being written
+        while (segments.size() > 1 && stats.diskBytes > options.diskBudgetBytes)
+        {
+            drop_oldest_segment();
+        }
+    }
+
+    const IndexEntry* find_entry(TrackAlias track, ObjectPosition position) const
+    {
+        auto iter = index.find(track);
+        if (iter == index.end())
+        {
+            return nullptr;
+        }
+        const std::vector<IndexEntry>& entries = iter->second;
+        auto entry = std::lower_bound(entries.begin(), entries.end(), position, before);
+        if (entry == entries.end() || entry->group != position.group ||
+            entry->object != position.object)
+        {
+            return nullptr;
+        }
+        return &*entry;
+    }
+
+    /**
+     * @brief Reads a spilled payload: mmap for sealed segments, pread for the active one
+     */
+    std::string_view read_entry(const IndexEntry& entry, std::string& scratch) const
+    {
+        Segment* segment = find_segment(entry.segment);
+        if (segment == nullptr)
+        {
+            return {};
+        }
+        if (segment->sealed)
+        {
+            if (segment->mapping == nullptr)
+            {
+                void* mapping = ::mmap(nullptr, segment->size, PROT_READ, MAP_SHARED, segment->fd, 0);
+                if (mapping == MAP_FAILED)
+                {
+                    throw_errno("SegmentCache: mmap failed");
+                }
+                segment->mapping = static_cast<const char*>(mapping);
+            }
+            return std::string_view(segment->mapping + entry.offset, entry.length);
+        }
+
+        scratch.resize(entry.length);
+        std::size_t done = 0;
+        while (done < entry.length)
+        {
+            ssize_t got = ::pread(segment->fd, &scratch[done], entry.length - done,
+                                  static_cast<off_t>(entry.offset + done));
+            if (got < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (got <= 0)
+            {
+                throw_errno("SegmentCache: segment read failed");
+            }
+            done += static_cast<std::size_t>(got);
+        }
+        return scratch;
+    }
+
+public:
+    explicit SegmentCache(Options options) : options(std::move(options)) {}
+
+    ~SegmentCache()
+    {
+        while (!segments.empty())
+        {
+            drop_oldest_segment();
+        }
+    }
+
+    SegmentCache(const SegmentCache&) = delete;
+    SegmentCache& operator=(const SegmentCache&) = delete;
+
+    /**
+     * @brief Adds an object to the in-memory tier, spilling the oldest groups if over budget
+     */
+    void put(TrackAlias track, ObjectPosition position, std::string_view payload)
+    {
+        if (find_entry(track, position) != nullptr)
+        {
+            return; // Already spilled
+        }
+
+        GroupKey key{track, position.group};
+        auto [iter, inserted] = hotGroups.try_emplace(key);
+        if (inserted)
+        {
+            hotOrder.push_back(key);
+        }
+
+        HotGroup& group = iter->second;
+        auto object = std::lower_bound(
+            group.objects.begin(), group.objects.end(), position.object,
+            [](const auto& entry, std::uint64_t objectId) { return entry.first < objectId; });
+        if (object != group.objects.end() && object->first == position.object)
+        {
+            return; // Already cached
+        }
+        group.objects.emplace(object, position.object, std::string(payload));
+        group.bytes += payload.size();
+        stats.memoryBytes += payload.size();
+
+        // Keep the newest group in memory even if it alone exceeds the budget
+        while (stats.memoryBytes > options.memoryBudgetBytes && hotOrder.size() > 1)
+        {
+            spill_oldest_group();
+        }
+    }
+
+    /**
+     * @brief Copies an object's payload from whichever tier holds it
+     * @return false if the object is not cached (never seen, or aged out of the disk budget)
+     */
+    bool get(TrackAlias track, ObjectPosition position, std::string& out) const
+    {
+        // A group split across tiers has a hot part too, so a miss there falls through to disk
+        auto hot = hotGroups.find({track, position.group});
+        if (hot != hotGroups.end())
+        {
+            const auto& objects = hot->second.objects;
+            auto object = std::lower_bound(
+                objects.begin(), objects.end(), position.object,
+                [](const auto& entry, std::uint64_t objectId) { return entry.first < objectId; });
+            if (object != objects.end() && object->first == position.object)
+            {
+                out = object->second;
+                return true;
+            }
+        }
+
+        const IndexEntry* entry = find_entry(track, position);
+        if (entry == nullptr)
+        {
+            return false;
+        }
+        std::string scratch;
+        std::string_view payload = read_entry(*entry, scratch);
+        out.assign(payload.data(), payload.size());
+        return true;
+    }
+
+    /**
+     * @brief Locates a spilled object for zero-copy sending from the page cache
+     * @return false if the object is in memory or not cached
+     */
+    bool locate(TrackAlias track, ObjectPosition position, DiskSlice& slice) const
+    {
+        const IndexEntry* entry = find_entry(track, position);
+        Segment* segment = entry ? find_segment(entry->segment) : nullptr;
+        if (segment == nullptr)
+        {
+            return false;
+        }
+        slice = {segment->fd, static_cast<off_t>(entry->offset), entry->length};
+        return true;
+    }
+
+    /**
+     * @brief Visits cached objects of a track in [from, to) in (group, object) order, for
+     *        subscribe-from-past and fetch; fn(ObjectPosition, std::string_view)
+     *
+     * A group can be split across tiers (objects arriving after it was spilled are held in
+     * memory), so the spilled and in-memory objects are merged by position.
+     */
+    template <typename Fn>
+    void for_range(TrackAlias track, ObjectPosition from, ObjectPosition to, Fn&& fn) const
+    {
+        std::vector<std::pair<ObjectPosition, std::string_view>> hotObjects;
+        for (auto hot = hotGroups.lower_bound({track, from.group});
+             hot != hotGroups.end() && hot->first.first == track && hot->first.second <= to.group;
+             ++hot)
+        {
+            for (const auto& [objectId, payload] : hot->second.objects)
+            {
+                ObjectPosition position{hot->first.second, objectId};
+                if (!(position < from) && position < to)
+                {
+                    hotObjects.emplace_back(position, payload);
+                }
+            }
+        }
+
+        const IndexEntry* spilled = nullptr;
+        const IndexEntry* spilledEnd = nullptr;
+        auto iter = index.find(track);
+        if (iter != index.end())
+        {
+            const std::vector<IndexEntry>& entries = iter->second;
+            spilled = entries.data() +
+                      (std::lower_bound(entries.begin(), entries.end(), from, before) - entries.begin());
+            spilledEnd = entries.data() + entries.size();
+        }
+
+        // An object lives in exactly one tier, so the merge never sees a position twice
+        std::string scratch;
+        auto hot = hotObjects.begin();
+        for (;;)
+        {
+            bool haveSpilled = spilled != spilledEnd && before(*spilled, to);
+            bool haveHot = hot != hotObjects.end();
+            if (haveSpilled && (!haveHot || before(*spilled, hot->first)))
+            {
+                fn(ObjectPosition{spilled->group, spilled->object}, read_entry(*spilled, scratch));
+                ++spilled;
+            }
+            else if (haveHot)
+            {
+                fn(hot->first, hot->second);
+                ++hot;
+            }
+            else
+            {
+                break;
+            }
+        }
+    }
+
+    const Stats& cache_stats() const
+    {
+        return stats;
+    }
+};
+
+} // namespace rvn
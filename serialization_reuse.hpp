@@ -0,0 +1,26 @@
+#pragma once
+
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/util/delimited_message_util.h>
+
+namespace rvn::serialization
+{
+
+/**
+ * @brief Parses the next length-delimited message into an existing message object
+ * @tparam MessageType Protobuf message type
+ * @param istream Input stream positioned at the message's length prefix
+ * @param message Message to overwrite; cleared first, keeping its allocated capacity
+ * @return false if the stream did not hold a complete, valid message
+ *
+ * Same framing as deserialize<MessageType>(istream), for callers that keep one message object
+ * per type and reparse into it instead of constructing a fresh one per message.
+ */
+template <typename MessageType>
+bool deserialize(google::protobuf::io::IstreamInputStream& istream, MessageType& message)
+{
+    message.Clear();
+    return google::protobuf::util::ParseDelimitedFromZeroCopyStream(&message, &istream, nullptr);
+}
+
+} // namespace rvn::serialization
@@ -0,0 +1,294 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <object_position.hpp>
+#include <track_interner.hpp>
+
+namespace rvn
+{
+
+/**
+ * @brief How outgoing objects are packed onto QUIC streams
+ */
+enum class StreamMappingPolicy : std::uint8_t
+{
+    PerObject,   // New stream per object; maximal independence, maximal churn
+    PerGroup,    // Each group gets its own stream, at most groupPoolSize open per track
+    PerTrack,    // One long-lived stream per track
+    PerPriority, // One long-lived stream per priority level, shared by all tracks
+};
+
+/**
+ * @brief Per-track mapping configuration
+ */
+struct StreamMappingConfig
+{
+    StreamMappingPolicy policy = StreamMappingPolicy::PerGroup;
+    std::uint32_t groupPoolSize = 4; // Group streams a PerGroup track keeps open at once
+};
+
+/**
+ * @brief Send-side layer deciding which stream each outgoing object goes on
+ * @tparam StreamHandle Transport stream handle (HQUIC for msquic, StreamId for loopback)
+ *
+ * Opening a QUIC stream costs a frame, flow-control state and usually an allocation, so at
+ * high object rates stream churn, not bandwidth, becomes the limit. PerObject opens a stream
+ * per object; the caller passes it to finish() after the send. PerGroup gives each group its
+ * own stream, so a receiver can take the group from the stream. Group g uses pool slot
+ * g % groupPoolSize; when a later group takes over the slot, the old group's stream is
+ * finished and a new one opened, so consecutive groups stay independent for prioritisation
+ * and loss. A late object of a group whose stream was already finished goes on a one-shot
+ * stream like PerObject. PerTrack and PerPriority keep a single long-lived stream each.
+ * Streams idle for longer than the idle timeout are closed by close_idle(). Open counts and
+ * the recent open rate are tracked so the chosen policy can be checked against the workload.
+ *
+ * Not thread-safe; owned by the connection's send path.
+ */
+template <typename StreamHandle> class StreamMapper
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using OpenStream = std::function<StreamHandle(std::uint8_t priority)>;
+    using CloseStream = std::function<void(StreamHandle)>;
+
+    /**
+     * @brief Result of mapping one object
+     */
+    struct Mapping
+    {
+        StreamHandle stream;
+        bool finishAfterSend; // One-shot stream: pass it to finish() after the send
+    };
+
+    struct Stats
+    {
+        std::uint64_t streamsOpened = 0;
+        std::uint64_t streamsClosed = 0;
+        std::uint64_t objectsMapped = 0;
+        double recentOpensPerSecond = 0.0; // Over the last completed rate window
+    };
+
+private:
+    struct PooledStream
+    {
+        StreamHandle stream{};
+        bool open = false;
+        Clock::time_point lastUsed;
+        std::uint64_t group = 0; // PerGroup: the group this stream carries
+    };
+
+    struct TrackStreams
+    {
+        StreamMappingConfig config;
+        bool configured = false;
+        std::vector<PooledStream> pool; // PerGroup: groupPoolSize entries, PerTrack: one
+    };
+
+    OpenStream openStream;
+    CloseStream closeStream;
+    StreamMappingConfig defaultConfig;
+    Clock::duration idleTimeout;
+    std::vector<TrackStreams> tracks;                        // Indexed by TrackAlias
+    std::unordered_map<std::uint8_t, PooledStream> byPriority; // PerPriority streams
+    Stats stats;
+
+    static constexpr auto rateWindow = std::chrono::seconds(1);
+    Clock::time_point rateWindowStart = Clock::now();
+    std::uint64_t opensInWindow = 0;
+
+    TrackStreams& track(TrackAlias alias)
+    {
+        if (alias >= tracks.size())
+        {
+            tracks.resize(alias + 1);
+        }
+        TrackStreams& streams = tracks[alias];
+        if (!streams.configured)
+        {
+            streams.config = defaultConfig;
+            streams.configured = true;
+        }
+        return streams;
+    }
+
+    void note_open(Clock::time_point now)
+    {
+        stats.streamsOpened++;
+        if (now - rateWindowStart >= rateWindow)
+        {
+            std::chrono::duration<double> elapsed = now - rateWindowStart;
+            stats.recentOpensPerSecond = opensInWindow / elapsed.count();
+            rateWindowStart = now;
+            opensInWindow = 0;
+        }
+        opensInWindow++;
+    }
+
+    StreamHandle use(PooledStream& pooled, std::uint8_t priority, Clock::time_point now)
+    {
+        if (!pooled.open)
+        {
+            pooled.stream = openStream(priority);
+            pooled.open = true;
+            note_open(now);
+        }
+        pooled.lastUsed = now;
+        return pooled.stream;
+    }
+
+    void close(PooledStream& pooled)
+    {
+        if (pooled.open)
+        {
+            closeStream(pooled.stream);
+            pooled.open = false;
+            stats.streamsClosed++;
+        }
+    }
+
+public:
+    /**
+     * @brief Constructor for StreamMapper
+     * @param openStream Opens a new stream at the given priority
+     * @param closeStream Gracefully finishes a stream
+     * @param defaultConfig Mapping for tracks without explicit configuration
+     * @param idleTimeout Pooled streams unused for this long are closed by close_idle()
+     */
+    StreamMapper(OpenStream openStream, CloseStream closeStream,
+                 StreamMappingConfig defaultConfig = {},
+                 Clock::duration idleTimeout = std::chrono::seconds(30))
+        : openStream(std::move(openStream)), closeStream(std::move(closeStream)),
+          defaultConfig(defaultConfig), idleTimeout(idleTimeout)
+    {
+    }
+
+    /**
+     * @brief Overrides the mapping for one track; its pooled streams are reopened lazily
+     */
+    void configure_track(TrackAlias alias, StreamMappingConfig config)
+    {
+        TrackStreams& streams = track(alias);
+        for (PooledStream& pooled : streams.pool)
+        {
+            close(pooled);
+        }
+        streams.pool.clear();
+        streams.config = config;
+    }
+
+    /**
+     * @brief Chooses the stream for an outgoing object, opening one only when needed
+     */
+    Mapping map(TrackAlias alias, ObjectPosition position, std::uint8_t priority,
+                Clock::time_point now = Clock::now())
+    {
+        stats.objectsMapped++;
+        TrackStreams& streams = track(alias);
+        switch (streams.config.policy)
+        {
+        case StreamMappingPolicy::PerObject:
+        {
+            StreamHandle stream = openStream(priority);
+            note_open(now);
+            return {stream, true};
+        }
+        case StreamMappingPolicy::PerGroup:
+        {
+            std::uint32_t poolSize = streams.config.groupPoolSize ? streams.config.groupPoolSize : 1;
+            if (streams.pool.size() != poolSize)
+            {
+                streams.pool.resize(poolSize);
+            }
+            PooledStream& pooled = streams.pool[position.group % poolSize];
+            if (pooled.open && pooled.group != position.group)
+            {
+                if (position.group < pooled.group)
+                {
+                    // Its group stream is already finished
+                    StreamHandle stream = openStream(priority);
+                    note_open(now);
+                    return {stream, true};
+                }
+                close(pooled); // A later group takes over the slot
+            }
+            pooled.group = position.group;
+            return {use(pooled, priority, now), false};
+        }
+        case StreamMappingPolicy::PerTrack:
+        {
+            if (streams.pool.empty())
+            {
+                streams.pool.resize(1);
+            }
+            return {use(streams.pool.front(), priority, now), false};
+        }
+        case StreamMappingPolicy::PerPriority:
+        default:
+            return {use(byPriority[priority], priority, now), false};
+        }
+    }
+
+    /**
+     * @brief Finishes a one-shot stream (Mapping::finishAfterSend) once its object is sent
+     */
+    void finish(StreamHandle stream)
+    {
+        closeStream(stream);
+        stats.streamsClosed++;
+    }
+
+    /**
+     * @brief Closes pooled streams that have been idle longer than the idle timeout
+     */
+    void close_idle(Clock::time_point now = Clock::now())
+    {
+        auto closeIfIdle = [&](PooledStream& pooled) {
+            if (pooled.open && now - pooled.lastUsed >= idleTimeout)
+            {
+                close(pooled);
+            }
+        };
+        for (TrackStreams& streams : tracks)
+        {
+            for (PooledStream& pooled : streams.pool)
+            {
+                closeIfIdle(pooled);
+            }
+        }
+        for (auto& [priority, pooled] : byPriority)
+        {
+            closeIfIdle(pooled);
+        }
+    }
+
+    /**
+     * @brief Closes every pooled stream (connection teardown or drain)
+     */
+    void close_all()
+    {
+        for (TrackStreams& streams : tracks)
+        {
+            for (PooledStream& pooled : streams.pool)
+            {
+                close(pooled);
+            }
+        }
+        for (auto& [priority, pooled] : byPriority)
+        {
+            close(pooled);
+        }
+    }
+
+    const Stats& mapping_stats() const
+    {
+        return stats;
+    }
+};
+
+} // namespace rvn
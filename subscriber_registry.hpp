@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+enum class SubscriberTier : uint8_t { Free, Paid };
+
+// Per-tier behavior as data: response tag and request allowance (0 = unlimited)
+struct TierPolicy {
+    char tag;
+    uint32_t maxRequests;
+};
+
+inline constexpr TierPolicy kTierPolicies[] = {
+    {'F', 100}, // Free
+    {'P', 0},   // Paid
+};
+
+// Subscriber sessions stored as struct-of-arrays in dense slots.
+// A session is an ID, a tier and its quota counter, one entry in each column; there is no
+// per-session heap object or vtable. Tier behavior is looked up in kTierPolicies by tier, so
+// serving a request is a few array loads. Removal swaps the last session into the freed slot
+// to keep the columns dense; slots are therefore only stable until the next remove().
+class SubscriberRegistry {
+private:
+    std::vector<uint64_t> ids_;
+    std::vector<SubscriberTier> tiers_;
+    std::vector<uint32_t> requestCounts_;
+    std::unordered_map<uint64_t, uint32_t> slots_;
+
+public:
+    uint32_t add(uint64_t subscriberId, SubscriberTier tier) {
+        auto [it, inserted] = slots_.try_emplace(subscriberId, static_cast<uint32_t>(ids_.size()));
+        if (!inserted) {
+            throw std::invalid_argument("Subscriber already registered");
+        }
+        ids_.push_back(subscriberId);
+        tiers_.push_back(tier);
+        requestCounts_.push_back(0);
+        return it->second;
+    }
+
+    bool remove(uint64_t subscriberId) {
+        auto it = slots_.find(subscriberId);
+        if (it == slots_.end()) {
+            return false;
+        }
+        uint32_t slot = it->second;
+        uint32_t last = static_cast<uint32_t>(ids_.size() - 1);
+        if (slot != last) {
+            ids_[slot] = ids_[last];
+            tiers_[slot] = tiers_[last];
+            requestCounts_[slot] = requestCounts_[last];
+            slots_[ids_[slot]] = slot;
+        }
+        ids_.pop_back();
+        tiers_.pop_back();
+        requestCounts_.pop_back();
+        slots_.erase(it);
+        return true;
+    }
+
+    std::optional<uint32_t> find(uint64_t subscriberId) const {
+        auto it = slots_.find(subscriberId);
+        if (it == slots_.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    uint64_t id(uint32_t slot) const { return ids_[slot]; }
+    SubscriberTier tier(uint32_t slot) const { return tiers_[slot]; }
+    const TierPolicy& policy(uint32_t slot) const { return kTierPolicies[static_cast<uint8_t>(tiers_[slot])]; }
+
+    // True if the session may issue another quota-counted request
+    bool has_quota(uint32_t slot) const {
+        uint32_t maxRequests = policy(slot).maxRequests;
+        return maxRequests == 0 || requestCounts_[slot] < maxRequests;
+    }
+
+    void count_request(uint32_t slot) { requestCounts_[slot]++; }
+
+    std::size_t size() const { return ids_.size(); }
+};
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <metrics.hpp>
+#include <track_interner.hpp>
+
+namespace rvn
+{
+
+/**
+ * @brief Per-subscription state kept on the connection that issued the SUBSCRIBE
+ */
+struct SubscriptionState
+{
+    TrackAlias trackAlias = 0;         // Interned full track name
+    std::uint64_t objectsReceived = 0; // Objects delivered under this subscription
+    MetricSeries metricSeries;         // Resolved from trackAlias at subscribe time
+    bool groupOpen = false;            // openGroup is counted as in flight by the drain controller
+    std::uint64_t openGroup = 0;
+};
+
+/**
+ * @brief Slab of per-connection subscriptions addressed by generation-checked subscribe IDs
+ * @tparam State Per-subscription payload stored in the slab
+ *
+ * Subscribe IDs are allocated by the table and encode a dense slot index in the low 32 bits
+ * and the slot's generation above it. Looking up an incoming object's subscribeId is one
+ * bounds-checked array access plus a generation compare; IDs of unsubscribed (and possibly
+ * reused) slots fail the compare and are rejected. Generations are kept to 30 bits so every
+ * ID fits in a QUIC varint. is_stale() tells such IDs apart from IDs this table never issued.
+ *
+ * Pointers returned by find() are invalidated by a later allocate().
+ */
+template <typename State = SubscriptionState> class SubscriptionTable
+{
+public:
+    using SubscribeId = std::uint64_t;
+
+private:
+    static constexpr std::uint32_t generationMask = (1u << 30) - 1;
+
+    struct Slot
+    {
+        State state;
+        std::uint32_t generation = 0;
+        bool live = false;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<std::uint32_t> freeSlots; // LIFO so recently used slots stay cache-hot
+    std::size_t liveCount = 0;
+
+    static SubscribeId make_id(std::uint32_t index, std::uint32_t generation)
+    {
+        return (static_cast<SubscribeId>(generation) << 32) | index;
+    }
+
+    Slot* slot_for(SubscribeId subscribeId)
+    {
+        std::uint64_t index = subscribeId & 0xFFFFFFFFu;
+        if (index >= slots.size())
+        {
+            return nullptr;
+        }
+        Slot& slot = slots[index];
+        if (!slot.live || slot.generation != (subscribeId >> 32))
+        {
+            return nullptr;
+        }
+        return &slot;
+    }
+
+public:
+    /**
+     * @brief Stores a new subscription and returns the subscribe ID to put on the wire
+     */
+    SubscribeId allocate(State state)
+    {
+        std::uint32_t index;
+        if (!freeSlots.empty())
+        {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else
+        {
+            index = static_cast<std::uint32_t>(slots.size());
+            slots.emplace_back();
+        }
+
+        Slot& slot = slots[index];
+        slot.state = std::move(state);
+        slot.live = true;
+        liveCount++;
+        return make_id(index, slot.generation);
+    }
+
+    /**
+     * @brief Finds the live subscription for an incoming subscribe ID
+     * @return Pointer to the state, or nullptr for unknown or stale IDs
+     */
+    State* find(SubscribeId subscribeId)
+    {
+        Slot* slot = slot_for(subscribeId);
+        return slot ? &slot->state : nullptr;
+    }
+
+    const State* find(SubscribeId subscribeId) const
+    {
+        return const_cast<SubscriptionTable*>(this)->find(subscribeId);
+    }
+
+    /**
+     * @brief True if the ID was issued by this table and its subscription has since ended
+     *
+     * IDs the table never issued (index beyond the slab, or a generation not yet reached) are
+     * not stale. Generation wrap-around is ignored: a slot would have to be reused 2^30 times.
+     */
+    bool is_stale(SubscribeId subscribeId) const
+    {
+        std::uint64_t index = subscribeId & 0xFFFFFFFFu;
+        return index < slots.size() && (subscribeId >> 32) < slots[index].generation;
+    }
+
+    /**
+     * @brief Ends a subscription; its ID (and any copy still in flight) becomes stale
+     * @return false if the ID was already unknown or stale
+     */
+    bool release(SubscribeId subscribeId)
+    {
+        Slot* slot = slot_for(subscribeId);
+        if (!slot)
+        {
+            return false;
+        }
+        slot->live = false;
+        slot->state = State{};
+        slot->generation = (slot->generation + 1) & generationMask;
+        freeSlots.push_back(static_cast<std::uint32_t>(slot - slots.data()));
+        liveCount--;
+        return true;
+    }
+
+    /**
+     * @brief Calls fn(subscribeId, state) for every live subscription
+     */
+    template <typename Fn> void for_each(Fn&& fn)
+    {
+        for (std::uint32_t index = 0; index < slots.size(); ++index)
+        {
+            if (slots[index].live)
+            {
+                fn(make_id(index, slots[index].generation), slots[index].state);
+            }
+        }
+    }
+
+    std::size_t size() const
+    {
+        return liveCount;
+    }
+};
+
+} // namespace rvn
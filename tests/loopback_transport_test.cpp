@@ -0,0 +1,178 @@
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <loopback_transport.hpp>
+
+using namespace rvn;
+
+/**
+ * @brief Messages on one stream arrive in send order even when earlier ones are retransmitted
+ */
+static void test_in_order_per_stream()
+{
+    LoopbackNetwork network(5);
+    LinkConfig config;
+    config.latency = 1'000;
+    config.lossRate = 0.3;
+    auto [sender, receiver] = network.connect(config);
+
+    std::vector<std::string> received;
+    receiver->set_receive_handler([&received](StreamId, std::string_view bytes) {
+        received.emplace_back(bytes);
+    });
+    for (int i = 0; i < 200; ++i)
+    {
+        sender->send(4, std::to_string(i));
+    }
+    assert(sender->queued() == 200);
+    assert(sender->active_streams() == 1);
+    network.run();
+
+    assert(received.size() == 200);
+    for (int i = 0; i < 200; ++i)
+    {
+        assert(received[i] == std::to_string(i));
+    }
+    assert(sender->link_stats().losses > 0);
+    assert(sender->queued() == 0);
+    assert(sender->active_streams() == 0);
+}
+
+/**
+ * @brief A loss on one stream delays only that stream; others keep flowing
+ */
+static void test_streams_are_independent()
+{
+    // Find a seed whose first transmission is lost and second is not
+    std::uint64_t seed = 1;
+    LinkConfig config;
+    config.latency = 1'000;
+    config.lossRate = 0.5;
+    for (;; ++seed)
+    {
+        LoopbackNetwork probe(seed);
+        auto [a, b] = probe.connect(config);
+        a->send(1, "x");
+        if (a->link_stats().losses != 1)
+        {
+            continue;
+        }
+        a->send(2, "y");
+        if (a->link_stats().losses == 1)
+        {
+            break;
+        }
+    }
+
+    LoopbackNetwork network(seed);
+    auto [sender, receiver] = network.connect(config);
+    std::vector<std::pair<StreamId, SimTime>> arrivals;
+    receiver->set_receive_handler([&](StreamId stream, std::string_view) {
+        arrivals.emplace_back(stream, network.now());
+    });
+    sender->send(1, "lost once");
+    sender->send(2, "on time");
+    network.run();
+
+    // Stream 2 is not held behind stream 1's retransmission
+    assert(arrivals.size() == 2);
+    assert(arrivals[0].first == 2 && arrivals[0].second == 1'000);
+    assert(arrivals[1].first == 1 && arrivals[1].second == 3'000);
+    assert(sender->active_streams() == 0);
+}
+
+/**
+ * @brief Each loss adds the retransmit delay (one RTT by default) plus another serialization
+ */
+static void test_retransmission_delay()
+{
+    LinkConfig config;
+    config.latency = 5'000;
+    config.bandwidthBps = 1'000'000'000; // 1 ns per byte
+    config.lossRate = 0.5;
+    config.retransmitDelay = 20'000;
+
+    LoopbackNetwork network(9);
+    auto [sender, receiver] = network.connect(config);
+    SimTime arrival = 0;
+    receiver->set_receive_handler([&](StreamId, std::string_view) { arrival = network.now(); });
+
+    const std::string message(100, 'm');
+    for (int i = 0; i < 50; ++i)
+    {
+        std::uint64_t lossesBefore = sender->link_stats().losses;
+        SimTime sentAt = network.now();
+        sender->send(static_cast<StreamId>(i), message);
+        std::uint64_t losses = sender->link_stats().losses - lossesBefore;
+        network.run();
+        assert(arrival - sentAt == 100 + 5'000 + losses * (20'000 + 100));
+    }
+    assert(sender->link_stats().losses > 0);
+    assert(sender->link_stats().messages == 50);
+}
+
+/**
+ * @brief The same seed replays the same losses and delivery times; another seed does not
+ */
+static void test_seed_determinism()
+{
+    auto run = [](std::uint64_t seed) {
+        LinkConfig config;
+        config.latency = 2'000;
+        config.lossRate = 0.2;
+        LoopbackNetwork network(seed);
+        auto [sender, receiver] = network.connect(config);
+        std::vector<SimTime> times;
+        receiver->set_receive_handler([&](StreamId, std::string_view) { times.push_back(network.now()); });
+        for (int i = 0; i < 100; ++i)
+        {
+            network.schedule(static_cast<SimTime>(i) * 500,
+                             [&sender, i] { sender->send(static_cast<StreamId>(i % 7), "m"); });
+        }
+        network.run();
+        return std::make_pair(times, sender->link_stats().losses);
+    };
+
+    auto first = run(42);
+    auto again = run(42);
+    auto other = run(43);
+    assert(first.first.size() == 100);
+    assert(first == again);
+    assert(first != other);
+}
+
+/**
+ * @brief Loss rates outside [0, 1) are refused
+ */
+static void test_rejects_invalid_loss_rate()
+{
+    LoopbackNetwork network;
+    LinkConfig config;
+    config.lossRate = 1.0;
+    bool threw = false;
+    try
+    {
+        network.connect(config);
+    }
+    catch (const std::invalid_argument&)
+    {
+        threw = true;
+    }
+    assert(threw);
+}
+
+int main()
+{
+    test_in_order_per_stream();
+    test_streams_are_independent();
+    test_retransmission_delay();
+    test_seed_determinism();
+    test_rejects_invalid_loss_rate();
+    std::cout << "loopback_transport_test: ok" << std::endl;
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include <alloc_tracker.hpp>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/util/delimited_message_util.h>
+#include <object_header_template.hpp>
+#include <serialization.hpp>
+
+using namespace rvn;
+
+namespace
+{
+
+struct Buffer
+{
+    std::uint32_t Length;
+    std::uint8_t* Buffer;
+};
+
+std::string delimited(const google::protobuf::MessageLite& message)
+{
+    std::string out;
+    google::protobuf::io::StringOutputStream stream(&out);
+    bool written = google::protobuf::util::SerializeDelimitedToZeroCopyStream(message, &stream);
+    assert(written);
+    return out;
+}
+
+std::string header_bytes()
+{
+    protobuf_messages::MessageHeader header;
+    header.set_messagetype(protobuf_messages::MoQtMessageType::OBJECT_STREAM);
+    return delimited(header);
+}
+
+/**
+ * @brief Builds one subscriber's copy through the template and compares it with the same
+ *        header and object message serialized the normal way
+ */
+void check(std::uint64_t subscribeId, std::uint64_t trackAlias, std::uint64_t group,
+           std::uint64_t object, const std::string& payload)
+{
+    protobuf_messages::ObjectStreamMessage shared;
+    shared.set_groupid(group);
+    shared.set_objectid(object);
+
+    ObjectHeaderTemplate objectTemplate(
+        shared, field_number<protobuf_messages::ObjectStreamMessage>("subscribeid"),
+        field_number<protobuf_messages::ObjectStreamMessage>("trackalias"),
+        field_number<protobuf_messages::ObjectStreamMessage>("objectpayload"), payload,
+        header_bytes());
+
+    // The per-subscriber fan-out step never allocates (enforced with -DALLOC_TRACKING)
+    ObjectHeaderTemplate::Prefix prefix;
+    Buffer buffers[ObjectHeaderTemplate::bufferCount];
+    std::size_t used;
+    {
+        alloc_tracking::NoAllocationScope noAllocations;
+        prefix = objectTemplate.make_prefix(subscribeId, trackAlias);
+        used = objectTemplate.gather(prefix, buffers);
+    }
+    std::string templated;
+    for (std::size_t i = 0; i < used; ++i)
+    {
+        templated.append(reinterpret_cast<const char*>(buffers[i].Buffer), buffers[i].Length);
+    }
+    assert(templated.size() == objectTemplate.wire_size(prefix));
+
+    protobuf_messages::ObjectStreamMessage full = shared;
+    full.set_subscribeid(subscribeId);
+    full.set_trackalias(trackAlias);
+    full.set_objectpayload(payload);
+    std::string expectedHeader = header_bytes();
+    std::string expected = expectedHeader + delimited(full);
+
+    // The header bytes are shared verbatim
+    assert(templated.compare(0, expectedHeader.size(), expectedHeader) == 0);
+
+    // The message is framed exactly: its length prefix covers everything that follows
+    google::protobuf::io::ArrayInputStream stream(templated.data() + expectedHeader.size(),
+                                                  static_cast<int>(templated.size() - expectedHeader.size()));
+    protobuf_messages::ObjectStreamMessage parsed;
+    bool parsedOk = google::protobuf::util::ParseDelimitedFromZeroCopyStream(&parsed, &stream, nullptr);
+    assert(parsedOk);
+    const void* rest;
+    int restSize;
+    bool trailing = stream.Next(&rest, &restSize);
+    assert(!trailing);
+
+    // ...and decodes to the normally built message
+    assert(parsed.SerializeAsString() == full.SerializeAsString());
+
+    // Fields are written even when zero (proto3 would omit them), so sizes match only if set
+    if (subscribeId != 0 && trackAlias != 0 && !payload.empty())
+    {
+        assert(templated.size() == expected.size());
+    }
+}
+
+} // namespace
+
+int main()
+{
+    const std::string payloads[] = {"", "x", std::string(127, 'a'), std::string(300, 'b')};
+    const std::uint64_t subscribeIds[] = {0, 1, 127, 128, (std::uint64_t{7} << 32) | 3};
+    const std::uint64_t aliases[] = {0, 1, 300, 1u << 21, 0xFFFFFFFFu};
+    const std::uint64_t groups[] = {0, 5, std::uint64_t{1} << 40};
+    const std::uint64_t objects[] = {0, 1, 1000};
+
+    for (const std::string& payload : payloads)
+    {
+        for (std::uint64_t subscribeId : subscribeIds)
+        {
+            for (std::uint64_t alias : aliases)
+            {
+                for (std::uint64_t group : groups)
+                {
+                    for (std::uint64_t object : objects)
+                    {
+                        check(subscribeId, alias, group, object, payload);
+                    }
+                }
+            }
+        }
+    }
+
+    std::cout << "object_header_template_test: ok" << std::endl;
+    return 0;
+}
@@ -0,0 +1,201 @@
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <relay_node.hpp>
+
+using namespace rvn;
+
+namespace
+{
+
+void link(LoopbackNetwork& network, RelayNode& upstream, RelayNode& downstream,
+          const LinkConfig& config)
+{
+    auto [upstreamEnd, downstreamEnd] = network.connect(config);
+    upstream.add_downstream(upstreamEnd);
+    downstream.add_upstream(downstreamEnd);
+}
+
+bool strictly_increasing(const std::vector<ObjectPosition>& positions)
+{
+    for (std::size_t i = 1; i < positions.size(); ++i)
+    {
+        if (!(positions[i - 1] < positions[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void send_subscribe(Transport* transport, std::uint64_t subscribeId, std::string_view name)
+{
+    std::string frame;
+    frame.push_back(static_cast<char>(relay_wire::FrameType::SUBSCRIBE));
+    relay_wire::put_varint(frame, subscribeId);
+    relay_wire::put_varint(frame, 0);
+    relay_wire::put_varint(frame, 0);
+    relay_wire::put_string(frame, "live");
+    relay_wire::put_string(frame, name);
+    transport->send(0, std::move(frame));
+}
+
+} // namespace
+
+/**
+ * @brief origin -> relay -> edge -> viewers: every viewer gets every object in order, and each
+ *        tier holds one upstream subscription per track however many viewers it serves
+ */
+static void test_cascade_aggregates_subscriptions()
+{
+    TrackNameInterner interner;
+    LoopbackNetwork network(3);
+    LinkConfig config;
+    config.latency = 1'000'000;
+
+    RelayNode origin(256, interner);
+    RelayNode relay(256, interner);
+    RelayNode edge(256, interner);
+    link(network, origin, relay, config);
+    link(network, relay, edge, config);
+
+    const int viewerCount = 8;
+    std::vector<std::unique_ptr<RelayNode>> viewers;
+    std::vector<std::vector<ObjectPosition>> received(viewerCount);
+    for (int i = 0; i < viewerCount; ++i)
+    {
+        viewers.emplace_back(new RelayNode(0, interner));
+        link(network, edge, *viewers.back(), config);
+        viewers.back()->set_object_handler(
+            [&received, i](TrackAlias, ObjectPosition position, std::string_view) {
+                received[i].push_back(position);
+            });
+        viewers.back()->subscribe("live", "video");
+        if (i % 2 == 0)
+        {
+            viewers.back()->subscribe("live", "audio");
+        }
+    }
+    network.run();
+
+    assert(edge.upstream_subscription_count() == 2);
+    assert(relay.upstream_subscription_count() == 2);
+    assert(edge.relay_stats().upstreamSubscribes == 2);
+
+    for (std::uint64_t k = 0; k < 40; ++k)
+    {
+        network.schedule(network.now() + k * 100'000, [&origin, k] {
+            origin.publish("live", "video", {k / 10, k % 10}, "v");
+        });
+    }
+    network.run();
+
+    // Each object crosses every upper hop once, whatever the fan-out below
+    assert(origin.relay_stats().objectsForwarded == 40);
+    assert(relay.relay_stats().objectsForwarded == 40);
+    assert(edge.relay_stats().objectsForwarded == 40 * viewerCount);
+    for (const auto& positions : received)
+    {
+        assert(positions.size() == 40);
+        assert(strictly_increasing(positions));
+    }
+}
+
+/**
+ * @brief Failing over to a warm standby mid-stream loses and repeats nothing; objects still in
+ *        flight from the failed upstream are dropped as stale
+ */
+static void test_failover_without_gaps_or_repeats()
+{
+    TrackNameInterner interner;
+    LoopbackNetwork network(11);
+    LinkConfig config;
+    config.latency = 2'000'000;
+    config.lossRate = 0.05;
+
+    RelayNode origin(256, interner);
+    RelayNode primary(256, interner);
+    RelayNode standby(256, interner);
+    RelayNode edge(256, interner);
+    RelayNode viewer(0, interner);
+    link(network, origin, primary, config);
+    link(network, origin, standby, config);
+    link(network, primary, edge, config);
+    link(network, standby, edge, config);
+    link(network, edge, viewer, config);
+
+    std::vector<ObjectPosition> received;
+    viewer.set_object_handler([&received](TrackAlias, ObjectPosition position, std::string_view) {
+        received.push_back(position);
+    });
+    viewer.subscribe("live", "video");
+    standby.subscribe("live", "video"); // Keeps the standby warm
+    network.run();
+
+    for (std::uint64_t k = 0; k < 200; ++k)
+    {
+        network.schedule(network.now() + k * 1'000'000, [&origin, k] {
+            origin.publish("live", "video", {k / 20, k % 20}, "payload");
+        });
+    }
+    network.run_until(network.now() + 100'000'000);
+
+    bool failedOver = edge.fail_over();
+    assert(failedOver);
+    network.run();
+
+    assert(received.size() == 200);
+    assert(strictly_increasing(received));
+    assert(edge.relay_stats().failovers == 1);
+    assert(edge.relay_stats().staleDropped > 0);
+    assert(edge.upstream_subscription_count() == 1);
+
+    bool noStandbyLeft = !edge.fail_over();
+    assert(noStandbyLeft);
+}
+
+/**
+ * @brief A downstream session may not reuse a live subscribe ID or use the reserved largest ID
+ */
+static void test_rejects_reused_and_reserved_subscribe_ids()
+{
+    TrackNameInterner interner;
+    LoopbackNetwork network;
+    RelayNode origin(256, interner);
+    auto [originEnd, viewerEnd] = network.connect();
+    origin.add_downstream(originEnd);
+
+    std::vector<std::pair<StreamId, std::string>> frames;
+    viewerEnd->set_receive_handler([&frames](StreamId stream, std::string_view bytes) {
+        frames.emplace_back(stream, std::string(bytes));
+    });
+
+    send_subscribe(viewerEnd, 5, "video");
+    send_subscribe(viewerEnd, 5, "audio");
+    send_subscribe(viewerEnd, std::numeric_limits<std::uint64_t>::max(), "audio");
+    network.run();
+    assert(origin.relay_stats().subscribesRejected == 2);
+
+    origin.publish("live", "video", {0, 0}, "v");
+    origin.publish("live", "audio", {0, 0}, "a");
+    network.run();
+
+    // Only the first subscription is served, on its own object stream
+    assert(frames.size() == 1);
+    assert(frames[0].first == 6);
+    assert(origin.relay_stats().objectsForwarded == 1);
+}
+
+int main()
+{
+    test_cascade_aggregates_subscriptions();
+    test_failover_without_gaps_or_repeats();
+    test_rejects_reused_and_reserved_subscribe_ids();
+    std::cout << "relay_node_test: ok" << std::endl;
+    return 0;
+}
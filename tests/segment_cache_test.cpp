@@ -0,0 +1,192 @@
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <segment_cache.hpp>
+
+using namespace rvn;
+
+namespace
+{
+
+const TrackAlias track = 0;
+
+// 40-byte payloads; on disk each takes 64 bytes with its record header
+std::string payload(std::uint64_t group, std::uint64_t object)
+{
+    std::string text = "g" + std::to_string(group) + "o" + std::to_string(object);
+    text.resize(40, '.');
+    return text;
+}
+
+std::string make_directory()
+{
+    char pattern[] = "/tmp/segment_cache_test.XXXXXX";
+    char* directory = ::mkdtemp(pattern);
+    assert(directory != nullptr);
+    return directory;
+}
+
+bool cached(const SegmentCache& cache, std::uint64_t group, std::uint64_t object)
+{
+    std::string out;
+    bool found = cache.get(track, {group, object}, out);
+    if (found)
+    {
+        assert(out == payload(group, object));
+    }
+    return found;
+}
+
+} // namespace
+
+/**
+ * @brief Going over the memory budget spills the oldest group, which stays readable from disk
+ */
+static void test_spill_oldest_group()
+{
+    std::string directory = make_directory();
+    {
+        SegmentCache cache({directory, 100, 1 << 20, 1 << 20});
+        cache.put(track, {0, 0}, payload(0, 0));
+        cache.put(track, {0, 1}, payload(0, 1));
+        assert(cache.cache_stats().groupsSpilled == 0);
+
+        cache.put(track, {1, 0}, payload(1, 0));
+        assert(cache.cache_stats().groupsSpilled == 1);
+        assert(cache.cache_stats().memoryBytes == 40);
+        assert(cache.cache_stats().diskBytes == 128);
+
+        assert(cached(cache, 0, 0));
+        assert(cached(cache, 0, 1));
+        assert(cached(cache, 1, 0));
+        assert(!cached(cache, 0, 2));
+
+        SegmentCache::DiskSlice slice;
+        bool spilled = cache.locate(track, {0, 1}, slice);
+        assert(spilled);
+        assert(slice.length == 40);
+        bool inMemory = cache.locate(track, {1, 0}, slice);
+        assert(!inMemory);
+    }
+    ::rmdir(directory.c_str());
+}
+
+/**
+ * @brief Objects arriving after their group was spilled are held in memory; lookups and
+ *        range reads see both parts of the group
+ */
+static void test_split_group()
+{
+    std::string directory = make_directory();
+    {
+        SegmentCache cache({directory, 100, 1 << 20, 1 << 20});
+        cache.put(track, {0, 0}, payload(0, 0));
+        cache.put(track, {0, 2}, payload(0, 2));
+        cache.put(track, {1, 0}, payload(1, 0));
+        assert(cache.cache_stats().groupsSpilled == 1);
+
+        // Late object of the spilled group
+        cache.put(track, {0, 1}, payload(0, 1));
+        assert(cache.cache_stats().groupsSpilled == 1);
+
+        // The hot part of group 0 lacks objects 0 and 2; they come from disk
+        assert(cached(cache, 0, 0));
+        assert(cached(cache, 0, 1));
+        assert(cached(cache, 0, 2));
+        assert(!cached(cache, 0, 3));
+
+        std::vector<ObjectPosition> visited;
+        cache.for_range(track, {0, 0}, {2, 0}, [&](ObjectPosition position, std::string_view data) {
+            assert(data == payload(position.group, position.object));
+            visited.push_back(position);
+        });
+        std::vector<ObjectPosition> expected{{0, 0}, {0, 1}, {0, 2}, {1, 0}};
+        assert(visited.size() == expected.size());
+        for (std::size_t i = 0; i < expected.size(); ++i)
+        {
+            assert(!(visited[i] < expected[i]) && !(expected[i] < visited[i]));
+        }
+    }
+    ::rmdir(directory.c_str());
+}
+
+/**
+ * @brief Sealed segments are read through mmap and the active one through pread; both return
+ *        the bytes that were spilled
+ */
+static void test_sealed_and_active_reads()
+{
+    std::string directory = make_directory();
+    {
+        // Two one-object groups (64 bytes each on disk) fill and seal a segment
+        SegmentCache cache({directory, 40, 128, 1 << 20});
+        for (std::uint64_t group = 0; group < 4; ++group)
+        {
+            cache.put(track, {group, 0}, payload(group, 0));
+        }
+        assert(cache.cache_stats().groupsSpilled == 3);
+        assert(cache.cache_stats().segments == 2);
+
+        // Groups 0 and 1 are in the sealed segment, group 2 in the active one
+        assert(cached(cache, 0, 0));
+        assert(cached(cache, 1, 0));
+        assert(cached(cache, 2, 0));
+        assert(cached(cache, 3, 0));
+
+        // A second read of the sealed segment reuses its mapping
+        assert(cached(cache, 0, 0));
+
+        SegmentCache::DiskSlice sealed;
+        SegmentCache::DiskSlice active;
+        bool foundSealed = cache.locate(track, {1, 0}, sealed);
+        bool foundActive = cache.locate(track, {2, 0}, active);
+        assert(foundSealed && foundActive);
+        assert(sealed.fd != active.fd);
+        assert(active.offset == 24);
+    }
+    ::rmdir(directory.c_str());
+}
+
+/**
+ * @brief Beyond the disk budget whole segments are dropped oldest first, never the active one
+ */
+static void test_disk_budget_eviction()
+{
+    std::string directory = make_directory();
+    {
+        // Every spilled group seals its own segment; the budget holds two of them
+        SegmentCache cache({directory, 40, 64, 128});
+        for (std::uint64_t group = 0; group < 6; ++group)
+        {
+            cache.put(track, {group, 0}, payload(group, 0));
+        }
+        assert(cache.cache_stats().groupsSpilled == 5);
+        assert(cache.cache_stats().segmentsDropped == 3);
+        assert(cache.cache_stats().segments == 2);
+        assert(cache.cache_stats().diskBytes == 128);
+
+        assert(!cached(cache, 0, 0));
+        assert(!cached(cache, 2, 0));
+        assert(cached(cache, 3, 0));
+        assert(cached(cache, 4, 0));
+        assert(cached(cache, 5, 0));
+
+        // Aged-out objects are accepted again as new ones
+        cache.put(track, {0, 0}, payload(0, 0));
+        assert(cached(cache, 0, 0));
+    }
+    ::rmdir(directory.c_str());
+}
+
+int main()
+{
+    test_spill_oldest_group();
+    test_split_group();
+    test_sealed_and_active_reads();
+    test_disk_budget_eviction();
+    std::cout << "segment_cache_test: ok" << std::endl;
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include <stream_mapping.hpp>
+
+using namespace rvn;
+
+namespace
+{
+
+using Mapper = StreamMapper<int>;
+
+/**
+ * @brief Fake transport handing out stream numbers and recording which ones were finished
+ */
+struct FakeStreams
+{
+    int nextStream = 1;
+    std::vector<int> closed;
+
+    Mapper mapper(StreamMappingConfig config,
+                  Mapper::Clock::duration idleTimeout = std::chrono::seconds(30))
+    {
+        return Mapper([this](std::uint8_t) { return nextStream++; },
+                      [this](int stream) { closed.push_back(stream); }, config, idleTimeout);
+    }
+};
+
+StreamMappingConfig policy(StreamMappingPolicy mappingPolicy, std::uint32_t groupPoolSize = 4)
+{
+    StreamMappingConfig config;
+    config.policy = mappingPolicy;
+    config.groupPoolSize = groupPoolSize;
+    return config;
+}
+
+const Mapper::Clock::time_point start{};
+
+} // namespace
+
+/**
+ * @brief PerObject opens a stream per object; it counts as closed only once finished
+ */
+static void test_per_object()
+{
+    FakeStreams streams;
+    Mapper mapper = streams.mapper(policy(StreamMappingPolicy::PerObject));
+
+    Mapper::Mapping first = mapper.map(0, {0, 0}, 1, start);
+    Mapper::Mapping second = mapper.map(0, {0, 1}, 1, start);
+    assert(first.finishAfterSend && second.finishAfterSend);
+    assert(first.stream != second.stream);
+    assert(mapper.mapping_stats().streamsOpened == 2);
+    assert(mapper.mapping_stats().streamsClosed == 0);
+
+    mapper.finish(first.stream);
+    assert(mapper.mapping_stats().streamsClosed == 1);
+    assert(streams.closed == std::vector<int>{first.stream});
+}
+
+/**
+ * @brief PerGroup keeps one stream per group and never lets two groups share one
+ */
+static void test_per_group()
+{
+    FakeStreams streams;
+    Mapper mapper = streams.mapper(policy(StreamMappingPolicy::PerGroup, 2));
+
+    int group0 = mapper.map(0, {0, 0}, 1, start).stream;
+    int group1 = mapper.map(0, {1, 0}, 1, start).stream;
+    assert(group0 != group1);
+    assert(mapper.map(0, {0, 1}, 1, start).stream == group0);
+    assert(mapper.map(0, {1, 1}, 1, start).stream == group1);
+    assert(mapper.mapping_stats().streamsOpened == 2);
+
+    // Group 2 takes over group 0's slot: group 0's stream is finished, not reused
+    Mapper::Mapping group2 = mapper.map(0, {2, 0}, 1, start);
+    assert(!group2.finishAfterSend);
+    assert(group2.stream != group0 && group2.stream != group1);
+    assert(streams.closed == std::vector<int>{group0});
+    assert(mapper.mapping_stats().streamsClosed == 1);
+
+    // A late object of group 0 gets a one-shot stream and leaves group 2's stream alone
+    Mapper::Mapping late = mapper.map(0, {0, 2}, 1, start);
+    assert(late.finishAfterSend);
+    assert(late.stream != group2.stream);
+    assert(mapper.map(0, {2, 1}, 1, start).stream == group2.stream);
+    mapper.finish(late.stream);
+    assert(mapper.mapping_stats().streamsClosed == 2);
+
+    // Tracks have separate pools
+    assert(mapper.map(1, {0, 0}, 1, start).stream != group2.stream);
+}
+
+/**
+ * @brief PerTrack uses one long-lived stream per track whatever the group
+ */
+static void test_per_track()
+{
+    FakeStreams streams;
+    Mapper mapper = streams.mapper(policy(StreamMappingPolicy::PerTrack));
+
+    int stream = mapper.map(0, {0, 0}, 1, start).stream;
+    assert(mapper.map(0, {5, 3}, 1, start).stream == stream);
+    assert(mapper.map(1, {0, 0}, 1, start).stream != stream);
+    assert(mapper.mapping_stats().streamsOpened == 2);
+    assert(mapper.mapping_stats().objectsMapped == 3);
+}
+
+/**
+ * @brief PerPriority shares one stream per priority level across tracks; configure_track()
+ *        switches a single track to its own policy
+ */
+static void test_per_priority_and_override()
+{
+    FakeStreams streams;
+    Mapper mapper = streams.mapper(policy(StreamMappingPolicy::PerPriority));
+
+    int high = mapper.map(0, {0, 0}, 1, start).stream;
+    assert(mapper.map(1, {0, 0}, 1, start).stream == high);
+    int low = mapper.map(0, {0, 1}, 7, start).stream;
+    assert(low != high);
+
+    mapper.configure_track(2, policy(StreamMappingPolicy::PerTrack));
+    int own = mapper.map(2, {0, 0}, 1, start).stream;
+    assert(own != high && own != low);
+    assert(mapper.mapping_stats().streamsOpened == 3);
+
+    mapper.close_all();
+    assert(streams.closed.size() == 3);
+    assert(mapper.mapping_stats().streamsClosed == 3);
+}
+
+/**
+ * @brief close_idle() finishes only streams unused for the idle timeout; they reopen lazily
+ */
+static void test_close_idle()
+{
+    FakeStreams streams;
+    Mapper mapper = streams.mapper(policy(StreamMappingPolicy::PerTrack), std::chrono::seconds(10));
+
+    int quiet = mapper.map(0, {0, 0}, 1, start).stream;
+    int busy = mapper.map(1, {0, 0}, 1, start).stream;
+    assert(mapper.map(1, {0, 1}, 1, start + std::chrono::seconds(8)).stream == busy);
+
+    mapper.close_idle(start + std::chrono::seconds(9));
+    assert(streams.closed.empty());
+
+    mapper.close_idle(start + std::chrono::seconds(12));
+    assert(streams.closed == std::vector<int>{quiet});
+
+    int reopened = mapper.map(0, {1, 0}, 1, start + std::chrono::seconds(13)).stream;
+    assert(reopened != quiet);
+    assert(mapper.map(1, {0, 2}, 1, start + std::chrono::seconds(13)).stream == busy);
+    assert(mapper.mapping_stats().streamsOpened == 3);
+    assert(mapper.mapping_stats().streamsClosed == 1);
+}
+
+int main()
+{
+    test_per_object();
+    test_per_group();
+    test_per_track();
+    test_per_priority_and_override();
+    test_close_idle();
+    std::cout << "stream_mapping_test: ok" << std::endl;
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <cassert>
+#include <iostream>
+
+#include <alloc_tracker.hpp>
+#include <subscription_table.hpp>
+#include <track_interner.hpp>
+
+using namespace rvn;
+
+/**
+ * @brief Subscription lifecycle as seen by the message handler: SUBSCRIBE allocates a slot,
+ *        objects resolve through it, UNSUBSCRIBE releases it and later objects are stale
+ */
+static void test_subscribe_object_unsubscribe()
+{
+    TrackNameInterner interner;
+    SubscriptionTable<> subscriptions;
+
+    // SUBSCRIBE
+    SubscriptionState state;
+    state.trackAlias = interner.intern("live", "video");
+    SubscriptionTable<>::SubscribeId subscribeId = subscriptions.allocate(state);
+    assert(subscriptions.size() == 1);
+
+    // OBJECT under the ID put on the SUBSCRIBE
+    SubscriptionState* subscription = subscriptions.find(subscribeId);
+    assert(subscription != nullptr);
+    assert(subscription->trackAlias == interner.intern("live", "video"));
+    subscription->objectsReceived++;
+    assert(!subscriptions.is_stale(subscribeId));
+
+    // UNSUBSCRIBE, then a late object
+    bool released = subscriptions.release(subscribeId);
+    assert(released);
+    assert(subscriptions.find(subscribeId) == nullptr);
+    assert(subscriptions.is_stale(subscribeId));
+    bool releasedTwice = subscriptions.release(subscribeId);
+    assert(!releasedTwice);
+    assert(subscriptions.size() == 0);
+
+    // The slot is reused under a new generation; the old ID stays stale
+    SubscriptionTable<>::SubscribeId reusedId = subscriptions.allocate(SubscriptionState{});
+    assert(reusedId != subscribeId);
+    assert((reusedId & 0xFFFFFFFFu) == (subscribeId & 0xFFFFFFFFu));
+    assert(subscriptions.find(reusedId) != nullptr);
+    assert(subscriptions.find(subscribeId) == nullptr);
+    assert(subscriptions.is_stale(subscribeId));
+}
+
+/**
+ * @brief IDs the table never issued are unknown, not stale (they take the pass-through path)
+ */
+static void test_foreign_ids_are_not_stale()
+{
+    SubscriptionTable<> subscriptions;
+    assert(!subscriptions.is_stale(0));
+    assert(!subscriptions.is_stale(7));
+
+    SubscriptionTable<>::SubscribeId subscribeId = subscriptions.allocate(SubscriptionState{});
+    assert(subscriptions.find(subscribeId + 1) == nullptr);
+    assert(!subscriptions.is_stale(subscribeId + 1));
+    assert(!subscriptions.is_stale(subscribeId + (std::uint64_t{1} << 32)));
+}
+
+/**
+ * @brief Matching objects to subscriptions never allocates, and neither does churn once the
+ *        slab has grown (enforced when built with -DALLOC_TRACKING)
+ */
+static void test_object_path_does_not_allocate()
+{
+    SubscriptionTable<> subscriptions;
+    SubscriptionTable<>::SubscribeId ids[64];
+    for (auto& subscribeId : ids)
+    {
+        subscribeId = subscriptions.allocate(SubscriptionState{});
+    }
+    SubscriptionTable<>::SubscribeId released = ids[5];
+    subscriptions.release(released);
+    ids[5] = subscriptions.allocate(SubscriptionState{});
+
+    alloc_tracking::AllocationCounter counter;
+    {
+        alloc_tracking::NoAllocationScope noAllocations;
+        for (int round = 0; round < 1000; ++round)
+        {
+            for (SubscriptionTable<>::SubscribeId subscribeId : ids)
+            {
+                SubscriptionState* subscription = subscriptions.find(subscribeId);
+                assert(subscription != nullptr);
+                subscription->objectsReceived++;
+            }
+            assert(subscriptions.find(released) == nullptr);
+            assert(subscriptions.is_stale(released));
+            assert(!subscriptions.is_stale(12345));
+
+            // UNSUBSCRIBE then SUBSCRIBE reuses the freed slot in place
+            bool freed = subscriptions.release(ids[round % 64]);
+            assert(freed);
+            ids[round % 64] = subscriptions.allocate(SubscriptionState{});
+        }
+    }
+    assert(counter.allocations() == 0);
+}
+
+int main()
+{
+    test_subscribe_object_unsubscribe();
+    test_foreign_ids_are_not_stale();
+    test_object_path_does_not_allocate();
+    std::cout << "subscription_table_test: ok" << std::endl;
+    return 0;
+}
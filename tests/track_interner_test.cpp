@@ -0,0 +1,92 @@
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+
+#include <subscription_table.hpp>
+#include <track_interner.hpp>
+
+using namespace rvn;
+
+/**
+ * @brief Aliases are dense, assigned in interning order and stable on re-interning
+ */
+static void test_dense_stable_aliases()
+{
+    TrackNameInterner interner;
+    TrackAlias video = interner.intern("live", "video");
+    TrackAlias audio = interner.intern("live", "audio");
+    assert(video == 0);
+    assert(audio == 1);
+    assert(interner.intern("live", "video") == video);
+    assert(interner.size() == 2);
+
+    assert(interner.name_of(audio).trackNamespace == "live");
+    assert(interner.name_of(audio).trackName == "audio");
+
+    bool threw = false;
+    try
+    {
+        interner.name_of(2);
+    }
+    catch (const std::out_of_range&)
+    {
+        threw = true;
+    }
+    assert(threw);
+}
+
+/**
+ * @brief Namespace and name are kept apart in the key, and find() never assigns an alias
+ */
+static void test_unambiguous_keys_and_find()
+{
+    TrackNameInterner interner;
+    TrackAlias split = interner.intern("a/b", "c");
+    TrackAlias other = interner.intern("a", "b/c");
+    assert(split != other);
+
+    TrackAlias alias = 99;
+    bool found = interner.find("a", "b/c", alias);
+    assert(found);
+    assert(alias == other);
+
+    alias = 99;
+    found = interner.find("a", "missing", alias);
+    assert(!found);
+    assert(alias == 99);
+    assert(interner.size() == 2);
+}
+
+/**
+ * @brief The alias path used by the message handler: a SUBSCRIBE received from the peer and
+ *        a subscription issued to the peer for the same track resolve to one alias, and the
+ *        issued subscription's slot carries it to every incoming object
+ */
+static void test_alias_shared_by_both_subscription_sides()
+{
+    TrackNameInterner interner;
+
+    // Publisher side: the peer's SUBSCRIBE is kept under the peer's own subscribe ID
+    TrackAlias received = interner.intern("live", "video");
+
+    // Subscriber side: our subscribe() stores the alias in the slot behind the ID we issue
+    SubscriptionTable<> subscriptions;
+    SubscriptionState state;
+    state.trackAlias = interner.intern("live", "video");
+    SubscriptionTable<>::SubscribeId subscribeId = subscriptions.allocate(state);
+
+    const SubscriptionState* subscription = subscriptions.find(subscribeId);
+    assert(subscription != nullptr);
+    assert(subscription->trackAlias == received);
+    assert(interner.name_of(subscription->trackAlias).trackName == "video");
+    assert(interner.size() == 1);
+}
+
+int main()
+{
+    test_dense_stable_aliases();
+    test_unambiguous_keys_and_find();
+    test_alias_shared_by_both_subscription_sides();
+    std::cout << "track_interner_test: ok" << std::endl;
+    return 0;
+}
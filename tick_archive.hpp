@@ -0,0 +1,352 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// One archived update
+struct TickRecord {
+    int64_t timestamp;
+    double lastTradedPrice;
+    double extraData;
+};
+
+// Append-only MSB-first bit stream
+class BitWriter {
+private:
+    std::vector<uint64_t> words_;
+    unsigned used_ = 64; // Bits used in the last word
+
+public:
+    // Appends the low `bits` bits of value (1..64)
+    void write(uint64_t value, unsigned bits) {
+        if (bits < 64) {
+            value &= (uint64_t{1} << bits) - 1;
+        }
+        if (used_ == 64) {
+            words_.push_back(0);
+            used_ = 0;
+        }
+        unsigned free = 64 - used_;
+        if (bits <= free) {
+            words_.back() |= value << (free - bits);
+            used_ += bits;
+        } else {
+            unsigned rest = bits - free;
+            words_.back() |= value >> rest;
+            words_.push_back(value << (64 - rest));
+            used_ = rest;
+        }
+    }
+
+    const std::vector<uint64_t>& words() const { return words_; }
+
+    std::vector<uint64_t> take() {
+        words_.shrink_to_fit();
+        used_ = 64;
+        return std::move(words_);
+    }
+};
+
+// Word-at-a-time reader: every read is one 64-bit window load plus a shift, no per-bit loop
+class BitReader {
+private:
+    const uint64_t* words_;
+    std::size_t wordCount_;
+    std::size_t pos_ = 0;
+
+public:
+    BitReader(const uint64_t* words, std::size_t wordCount) : words_(words), wordCount_(wordCount) {}
+
+    // Next 64 bits starting at the cursor, zero-padded past the end
+    uint64_t peek() const {
+        std::size_t word = pos_ >> 6;
+        unsigned offset = pos_ & 63;
+        uint64_t window = words_[word] << offset;
+        if (offset && word + 1 < wordCount_) {
+            window |= words_[word + 1] >> (64 - offset);
+        }
+        return window;
+    }
+
+    void skip(unsigned bits) { pos_ += bits; }
+
+    // Reads 1..64 bits
+    uint64_t read(unsigned bits) {
+        uint64_t value = peek() >> (64 - bits);
+        pos_ += bits;
+        return value;
+    }
+};
+
+// Delta-of-delta timestamp column.
+// Control prefixes: 0 (same delta), 10 + 7 bits, 110 + 9 bits, 1110 + 12 bits, 1111 + 64 bits,
+// with the delta-of-delta zigzag encoded.
+class TimestampColumn {
+private:
+    BitWriter bits_;
+    int64_t previous_ = 0;
+    int64_t previousDelta_ = 0;
+    uint32_t count_ = 0;
+
+    static uint64_t zigzag(int64_t value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+    static int64_t unzigzag(uint64_t value) { return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+
+public:
+    void append(int64_t timestamp) {
+        if (count_++ == 0) {
+            bits_.write(static_cast<uint64_t>(timestamp), 64);
+        } else {
+            int64_t delta = timestamp - previous_;
+            uint64_t encoded = zigzag(delta - previousDelta_);
+            if (encoded == 0) {
+                bits_.write(0b0, 1);
+            } else if (encoded < (1u << 7)) {
+                bits_.write((0b10u << 7) | encoded, 9);
+            } else if (encoded < (1u << 9)) {
+                bits_.write((0b110u << 9) | encoded, 12);
+            } else if (encoded < (1u << 12)) {
+                bits_.write((0b1110u << 12) | encoded, 16);
+            } else {
+                bits_.write(0b1111, 4);
+                bits_.write(encoded, 64);
+            }
+            previousDelta_ = delta;
+        }
+        previous_ = timestamp;
+    }
+
+    const std::vector<uint64_t>& words() const { return bits_.words(); }
+
+    std::vector<uint64_t> take() {
+        count_ = 0;
+        previous_ = 0;
+        previousDelta_ = 0;
+        return bits_.take();
+    }
+
+    static void decode(const uint64_t* words, std::size_t wordCount, uint32_t count, int64_t* out) {
+        if (count == 0) {
+            return;
+        }
+        BitReader reader(words, wordCount);
+        int64_t value = static_cast<int64_t>(reader.read(64));
+        int64_t delta = 0;
+        out[0] = value;
+        for (uint32_t i = 1; i < count; ++i) {
+            uint64_t window = reader.peek();
+            unsigned ones = window == ~uint64_t{0} ? 64 : static_cast<unsigned>(__builtin_clzll(~window));
+            uint64_t encoded;
+            switch (ones) {
+            case 0:
+                reader.skip(1);
+                encoded = 0;
+                break;
+            case 1:
+                encoded = (window >> (64 - 9)) & 0x7F;
+                reader.skip(9);
+                break;
+            case 2:
+                encoded = (window >> (64 - 12)) & 0x1FF;
+                reader.skip(12);
+                break;
+            case 3:
+                encoded = (window >> (64 - 16)) & 0xFFF;
+                reader.skip(16);
+                break;
+            default:
+                reader.skip(4);
+                encoded = reader.read(64);
+                break;
+            }
+            delta += unzigzag(encoded);
+            value += delta;
+            out[i] = value;
+        }
+    }
+};
+
+// XOR-compressed double column (Gorilla): 0 (repeat), 10 + bits inside the previous
+// leading/trailing-zero window, 11 + 5-bit leading zeros + 6-bit length + bits
+class ValueColumn {
+private:
+    BitWriter bits_;
+    uint64_t previous_ = 0;
+    unsigned leading_ = 65; // 65: no window yet
+    unsigned trailing_ = 0;
+    uint32_t count_ = 0;
+
+    static uint64_t to_bits(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+        return bits;
+    }
+
+public:
+    void append(double value) {
+        uint64_t current = to_bits(value);
+        if (count_++ == 0) {
+            bits_.write(current, 64);
+            previous_ = current;
+            return;
+        }
+        uint64_t xored = current ^ previous_;
+        previous_ = current;
+        if (xored == 0) {
+            bits_.write(0b0, 1);
+            return;
+        }
+        unsigned leading = std::min(31u, static_cast<unsigned>(__builtin_clzll(xored)));
+        unsigned trailing = static_cast<unsigned>(__builtin_ctzll(xored));
+        if (leading_ <= 64 && leading >= leading_ && trailing >= trailing_) {
+            bits_.write(0b10, 2);
+            bits_.write(xored >> trailing_, 64 - leading_ - trailing_);
+        } else {
+            unsigned length = 64 - leading - trailing;
+            bits_.write((0b11u << 11) | (leading << 6) | (length & 63), 13);
+            bits_.write(xored >> trailing, length);
+            leading_ = leading;
+            trailing_ = trailing;
+        }
+    }
+
+    const std::vector<uint64_t>& words() const { return bits_.words(); }
+
+    std::vector<uint64_t> take() {
+        count_ = 0;
+        previous_ = 0;
+        leading_ = 65;
+        trailing_ = 0;
+        return bits_.take();
+    }
+
+    // Decodes the first `count` values of a column
+    static void decode(const uint64_t* words, std::size_t wordCount, uint32_t count, double* out) {
+        if (count == 0) {
+            return;
+        }
+        BitReader reader(words, wordCount);
+        uint64_t value = reader.read(64);
+        std::memcpy(&out[0], &value, sizeof value);
+        unsigned leading = 0;
+        unsigned trailing = 0;
+        for (uint32_t i = 1; i < count; ++i) {
+            uint64_t window = reader.peek();
+            if ((window >> 63) == 0) {
+                reader.skip(1);
+            } else if ((window >> 62) == 0b10) {
+                unsigned length = 64 - leading - trailing;
+                reader.skip(2);
+                value ^= reader.read(length) << trailing;
+            } else {
+                leading = static_cast<unsigned>(window >> 57) & 31;
+                unsigned length = static_cast<unsigned>(window >> 51) & 63;
+                if (length == 0) {
+                    length = 64;
+                }
+                trailing = 64 - leading - length;
+                reader.skip(13);
+                value ^= reader.read(length) << trailing;
+            }
+            std::memcpy(&out[i], &value, sizeof value);
+        }
+    }
+};
+
+// Compressed per-instrument tick history.
+// Ticks are stored column by column (timestamps, prices, extra fields) in blocks of
+// kBlockTicks; a full block is sealed into immutable, exactly-sized word arrays. Range queries
+// skip blocks by their first/last timestamp and decode only the overlapping ones, one column
+// at a time into stack buffers, stopping each value column at the last tick in range.
+// Typical market data (regular timestamps, prices moving a few ticks) costs 1-3 bytes per
+// field instead of 8.
+class TickArchive {
+public:
+    static constexpr uint32_t kBlockTicks = 1024;
+
+private:
+    struct Block {
+        int64_t firstTimestamp;
+        int64_t lastTimestamp;
+        uint32_t count;
+        std::vector<uint64_t> timestamps;
+        std::vector<uint64_t> prices;
+        std::vector<uint64_t> extras;
+    };
+
+    std::vector<Block> sealed_;
+    TimestampColumn timestamps_;
+    ValueColumn prices_;
+    ValueColumn extras_;
+    int64_t openFirst_ = 0;
+    int64_t last_ = INT64_MIN;
+    uint32_t openCount_ = 0;
+
+    static void decode_range(const std::vector<uint64_t>& timestampWords, const std::vector<uint64_t>& priceWords,
+                             const std::vector<uint64_t>& extraWords, uint32_t count, int64_t from, int64_t to,
+                             std::vector<TickRecord>& out) {
+        int64_t timestamps[kBlockTicks];
+        double prices[kBlockTicks];
+        double extras[kBlockTicks];
+        TimestampColumn::decode(timestampWords.data(), timestampWords.size(), count, timestamps);
+        uint32_t begin = static_cast<uint32_t>(std::lower_bound(timestamps, timestamps + count, from) - timestamps);
+        uint32_t end = static_cast<uint32_t>(std::upper_bound(timestamps, timestamps + count, to) - timestamps);
+        if (begin >= end) {
+            return;
+        }
+        ValueColumn::decode(priceWords.data(), priceWords.size(), end, prices);
+        ValueColumn::decode(extraWords.data(), extraWords.size(), end, extras);
+        for (uint32_t i = begin; i < end; ++i) {
+            out.push_back({timestamps[i], prices[i], extras[i]});
+        }
+    }
+
+public:
+    // Appends a tick; timestamps must be non-decreasing
+    void append(int64_t timestamp, double lastTradedPrice, double extraData) {
+        if (timestamp < last_) {
+            throw std::invalid_argument("Tick timestamps must be non-decreasing");
+        }
+        if (openCount_ == 0) {
+            openFirst_ = timestamp;
+        }
+        timestamps_.append(timestamp);
+        prices_.append(lastTradedPrice);
+        extras_.append(extraData);
+        last_ = timestamp;
+        if (++openCount_ == kBlockTicks) {
+            sealed_.push_back({openFirst_, last_, openCount_, timestamps_.take(), prices_.take(), extras_.take()});
+            openCount_ = 0;
+        }
+    }
+
+    int64_t last_timestamp() const { return last_; }
+
+    // Ticks with from <= timestamp <= to, oldest first
+    std::vector<TickRecord> query(int64_t from, int64_t to) const {
+        std::vector<TickRecord> out;
+        auto first = std::lower_bound(sealed_.begin(), sealed_.end(), from,
+                                      [](const Block& block, int64_t t) { return block.lastTimestamp < t; });
+        for (auto it = first; it != sealed_.end() && it->firstTimestamp <= to; ++it) {
+            decode_range(it->timestamps, it->prices, it->extras, it->count, from, to, out);
+        }
+        if (openCount_ > 0 && openFirst_ <= to && last_ >= from) {
+            decode_range(timestamps_.words(), prices_.words(), extras_.words(), openCount_, from, to, out);
+        }
+        return out;
+    }
+
+    std::size_t size() const { return sealed_.size() * kBlockTicks + openCount_; }
+
+    std::size_t memory_bytes() const {
+        std::size_t bytes = sizeof(*this) + sealed_.capacity() * sizeof(Block);
+        for (const Block& block : sealed_) {
+            bytes += (block.timestamps.capacity() + block.prices.capacity() + block.extras.capacity()) * sizeof(uint64_t);
+        }
+        bytes += (timestamps_.words().capacity() + prices_.words().capacity() + extras_.words().capacity()) * sizeof(uint64_t);
+        return bytes;
+    }
+};
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <utility>
+#include <vector>
+
+enum class MoverRanking : uint8_t { Gainers, Losers, Volume };
+
+struct Mover {
+    uint64_t instrumentId;
+    double value; // Percent change since the session reference, or volume
+    double lastTradedPrice;
+};
+
+// Single-writer, multi-reader copy of one ranking's top entries, guarded by a sequence lock.
+// Fields are stored as relaxed atomics so readers racing a publish are well-defined; a reader
+// retries if the sequence moved while it copied.
+class MoverSnapshot {
+public:
+    static constexpr std::size_t kMaxEntries = 64;
+
+private:
+    std::atomic<uint64_t> sequence_{0};
+    std::atomic<uint32_t> count_{0};
+    std::array<std::atomic<uint64_t>, kMaxEntries * 3> cells_{};
+
+    static uint64_t bits(double value) {
+        uint64_t out;
+        std::memcpy(&out, &value, sizeof out);
+        return out;
+    }
+
+    static double value(uint64_t bits) {
+        double out;
+        std::memcpy(&out, &bits, sizeof out);
+        return out;
+    }
+
+public:
+    void publish(const std::vector<Mover>& movers) {
+        uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::size_t count = std::min(movers.size(), kMaxEntries);
+        for (std::size_t i = 0; i < count; ++i) {
+            cells_[i * 3].store(movers[i].instrumentId, std::memory_order_relaxed);
+            cells_[i * 3 + 1].store(bits(movers[i].value), std::memory_order_relaxed);
+            cells_[i * 3 + 2].store(bits(movers[i].lastTradedPrice), std::memory_order_relaxed);
+        }
+        count_.store(static_cast<uint32_t>(count), std::memory_order_relaxed);
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    std::vector<Mover> read() const {
+        std::vector<Mover> movers;
+        movers.reserve(kMaxEntries);
+        for (;;) {
+            uint64_t before = sequence_.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            movers.clear();
+            uint32_t count = count_.load(std::memory_order_relaxed);
+            for (uint32_t i = 0; i < count; ++i) {
+                movers.push_back({cells_[i * 3].load(std::memory_order_relaxed),
+                                  value(cells_[i * 3 + 1].load(std::memory_order_relaxed)),
+                                  value(cells_[i * 3 + 2].load(std::memory_order_relaxed))});
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before) {
+                return movers;
+            }
+        }
+    }
+};
+
+// Top gainers, losers and volume leaders maintained on every update.
+// Each ranking is an ordered tree of (value, instrument) pairs. An update re-keys the
+// instrument's existing node (extract, change the key, reinsert), O(log n) and without
+// allocating once the instrument has been seen. The top-N lists are republished to lock-free
+// snapshots only when the update touches the current top N (the old or new key reaches the
+// N-th key), so dashboards read a precomputed list instead of scanning the universe. Percent change is measured from
+// each instrument's session reference: its first price, or its price at reset_session().
+// Per-instrument state is indexed by the publisher's dense instrument index, and ties in a
+// ranking are broken by that index. Updates come from one thread; snapshots may be read from
+// any thread.
+class TopMovers {
+private:
+    using Key = std::pair<double, uint32_t>;
+
+    struct State {
+        bool seen = false;
+        uint64_t instrumentId = 0;
+        double reference = 0;
+        double price = 0;
+        Key change{0, 0};
+        Key volume{0, 0};
+        bool hasVolume = false;
+    };
+
+    std::size_t topN_;
+    std::vector<State> states_; // Per instrument index
+    std::set<Key> byChange_;
+    std::set<Key> byVolume_;
+    MoverSnapshot gainers_;
+    MoverSnapshot losers_;
+    MoverSnapshot volume_;
+    // N-th key of each list as last published; the lists cannot change while no update
+    // reaches them, so these stay valid between publishes
+    Key gainersCutoff_{0, 0};
+    Key losersCutoff_{0, 0};
+    Key volumeCutoff_{0, 0};
+    std::vector<Mover> scratch_;
+
+    template <typename It> void publish(It it, It end, MoverSnapshot& snapshot, Key& cutoff) {
+        scratch_.clear();
+        for (; it != end && scratch_.size() < topN_; ++it) {
+            const State& state = states_[it->second];
+            scratch_.push_back({state.instrumentId, it->first, state.price});
+            cutoff = *it;
+        }
+        snapshot.publish(scratch_);
+    }
+
+    void publish_change() {
+        publish(byChange_.rbegin(), byChange_.rend(), gainers_, gainersCutoff_);
+        publish(byChange_.begin(), byChange_.end(), losers_, losersCutoff_);
+    }
+
+    static bool reaches(const Key& key, const Key& cutoff, bool descending) {
+        return descending ? !(key < cutoff) : !(cutoff < key);
+    }
+
+    // Moves an instrument's node to its new key, reusing the node instead of reallocating it
+    static void rekey(std::set<Key>& ranking, bool inserted, const Key& oldKey, const Key& newKey) {
+        if (inserted) {
+            ranking.insert(newKey);
+            return;
+        }
+        auto node = ranking.extract(oldKey);
+        node.value() = newKey;
+        ranking.insert(std::move(node));
+    }
+
+    static double percent_change(double price, double reference) {
+        return reference != 0 ? (price - reference) / std::fabs(reference) * 100.0 : 0.0;
+    }
+
+public:
+    explicit TopMovers(std::size_t topN = 10) : topN_(std::max<std::size_t>(1, std::min(topN, MoverSnapshot::kMaxEntries))) {
+        scratch_.reserve(topN_);
+    }
+
+    void on_update(uint32_t instrument, uint64_t instrumentId, double price, double volume, bool hasVolume) {
+        if (std::isnan(price)) {
+            return;
+        }
+        if (instrument >= states_.size()) {
+            states_.resize(instrument + 1);
+        }
+        State& state = states_[instrument];
+        bool inserted = !state.seen;
+        if (inserted) {
+            state.seen = true;
+            state.instrumentId = instrumentId;
+            state.reference = price;
+        }
+        state.price = price;
+
+        Key oldChange = state.change;
+        Key newChange{percent_change(price, state.reference), instrument};
+        bool changeTouched = byChange_.size() < topN_ + (inserted ? 0 : 1) ||
+                             reaches(newChange, gainersCutoff_, true) || reaches(newChange, losersCutoff_, false) ||
+                             (!inserted && (reaches(oldChange, gainersCutoff_, true) || reaches(oldChange, losersCutoff_, false)));
+        rekey(byChange_, inserted, oldChange, newChange);
+        state.change = newChange;
+        if (changeTouched) {
+            publish_change();
+        }
+
+        if (hasVolume && !std::isnan(volume)) {
+            Key oldVolume = state.volume;
+            Key newVolume{volume, instrument};
+            bool volumeTouched = byVolume_.size() < topN_ + (state.hasVolume ? 1 : 0) ||
+                                 reaches(newVolume, volumeCutoff_, true) ||
+                                 (state.hasVolume && reaches(oldVolume, volumeCutoff_, true));
+            rekey(byVolume_, !state.hasVolume, oldVolume, newVolume);
+            state.volume = newVolume;
+            state.hasVolume = true;
+            if (volumeTouched) {
+                publish(byVolume_.rbegin(), byVolume_.rend(), volume_, volumeCutoff_);
+            }
+        }
+    }
+
+    // Starts a new session: every instrument's current price becomes its reference
+    void reset_session() {
+        for (uint32_t instrument = 0; instrument < states_.size(); ++instrument) {
+            State& state = states_[instrument];
+            if (state.seen) {
+                state.reference = state.price;
+                rekey(byChange_, false, state.change, {0, instrument});
+                state.change = {0, instrument};
+            }
+        }
+        publish_change();
+    }
+
+    // Lock-free read of the current top list
+    std::vector<Mover> top(MoverRanking ranking) const {
+        switch (ranking) {
+        case MoverRanking::Gainers:
+            return gainers_.read();
+        case MoverRanking::Losers:
+            return losers_.read();
+        case MoverRanking::Volume:
+        default:
+            return volume_.read();
+        }
+    }
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace rvn
+{
+
+/**
+ * @brief Dense internal identifier for a full track name (namespace + name)
+ *
+ * Aliases are assigned from 0 upwards in interning order and never reused, so they can
+ * index plain arrays in fan-out, cache and stats structures.
+ */
+using TrackAlias = std::uint32_t;
+
+/**
+ * @brief Full track name as carried by SUBSCRIBE / ANNOUNCE
+ */
+struct FullTrackName
+{
+    std::string trackNamespace;
+    std::string trackName;
+};
+
+/**
+ * @brief Maps full track names to dense 32-bit aliases
+ *
+ * Strings are hashed and compared once, when a track is first seen at subscribe or
+ * announce time. All per-object work afterwards uses the TrackAlias only. Interning
+ * takes an exclusive lock; lookups in either direction take a shared lock, and the
+ * reverse lookup returns a reference that stays valid for the interner's lifetime.
+ */
+class TrackNameInterner
+{
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string, TrackAlias> aliasByKey; // Keyed by make_key()
+    std::deque<FullTrackName> namesByAlias;                  // Stable references on growth
+
+    /**
+     * @brief Builds an unambiguous lookup key ("a/b" + "c" must differ from "a" + "b/c")
+     */
+    static std::string make_key(std::string_view trackNamespace, std::string_view trackName)
+    {
+        std::string key = std::to_string(trackNamespace.size());
+        key.reserve(key.size() + 1 + trackNamespace.size() + trackName.size());
+        key.push_back(':');
+        key.append(trackNamespace);
+        key.append(trackName);
+        return key;
+    }
+
+public:
+    /**
+     * @brief Returns the alias for a track, assigning the next dense alias if it is new
+     * @param trackNamespace Track namespace
+     * @param trackName Track name within the namespace
+     * @return Alias for the full track name
+     */
+    TrackAlias intern(std::string_view trackNamespace, std::string_view trackName)
+    {
+        std::string key = make_key(trackNamespace, trackName);
+        {
+            std::shared_lock lock(mutex);
+            auto iter = aliasByKey.find(key);
+            if (iter != aliasByKey.end())
+            {
+                return iter->second;
+            }
+        }
+
+        std::unique_lock lock(mutex);
+        auto [iter, inserted] =
+            aliasByKey.try_emplace(std::move(key), static_cast<TrackAlias>(namesByAlias.size()));
+        if (inserted)
+        {
+            namesByAlias.push_back({std::string(trackNamespace), std::string(trackName)});
+        }
+        return iter->second;
+    }
+
+    /**
+     * @brief Looks up an already interned track without assigning a new alias
+     * @param alias Output alias, written only when the track is known
+     * @return true if the track has been interned
+     */
+    bool find(std::string_view trackNamespace, std::string_view trackName, TrackAlias& alias) const
+    {
+        std::string key = make_key(trackNamespace, trackName);
+        std::shared_lock lock(mutex);
+        auto iter = aliasByKey.find(key);
+        if (iter == aliasByKey.end())
+        {
+            return false;
+        }
+        alias = iter->second;
+        return true;
+    }
+
+    /**
+     * @brief Reverse lookup for logging and control-plane replies
+     * @throws std::out_of_range if the alias was never assigned
+     */
+    const FullTrackName& name_of(TrackAlias alias) const
+    {
+        std::shared_lock lock(mutex);
+        if (alias >= namesByAlias.size())
+        {
+            throw std::out_of_range("Unknown track alias");
+        }
+        return namesByAlias[alias];
+    }
+
+    /**
+     * @brief Number of aliases assigned so far; every alias is below this value
+     */
+    std::size_t size() const
+    {
+        std::shared_lock lock(mutex);
+        return namesByAlias.size();
+    }
+};
+
+/**
+ * @brief Process-wide interner shared by all connections, so a track keeps one alias
+ *        across every subscriber and upstream session
+ */
+inline TrackNameInterner& track_interner()
+{
+    static TrackNameInterner interner;
+    return interner;
+}
+
+} // namespace rvn
@@ -1,19 +1,261 @@
 #include <iostream>
 #include <utility> // For std::move
+#include <atomic>
+#include <thread>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+#include "alloc_tracker.hpp"
+
+#ifdef UNIQUE_PTR_TRACKING
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <execinfo.h>
+#include <typeinfo>
+#include <unistd.h>
+#endif
+
+// Debug ownership tracking for UniquePtr.
+//
+// Build with -DUNIQUE_PTR_TRACKING to record every object a UniquePtr takes
+// ownership of, together with the stack that handed it over, in a fixed-size
+// lock-free registry. Objects that leave UniquePtr through release() stay in
+// the registry marked as released until a UniquePtr adopts them again, so
+// leaks through release() show up in the report. The report is printed at
+// exit and on demand via uniquePtrTracking::report().
+//
+// Without the flag the hooks below are empty inline functions: UniquePtr is
+// exactly pointer-sized and its members compile to the untracked code.
+namespace uniquePtrTracking {
+
+#ifdef UNIQUE_PTR_TRACKING
+
+#ifndef UNIQUE_PTR_TRACKING_CAPACITY
+#define UNIQUE_PTR_TRACKING_CAPACITY 16384
+#endif
+
+constexpr std::size_t CAPACITY = UNIQUE_PTR_TRACKING_CAPACITY;
+constexpr int MAX_FRAMES = 16;
+
+enum SlotState : std::uint32_t { OWNED = 1, RELEASED = 2 };
+
+// One registry slot. Metadata is guarded by a per-slot sequence counter
+// (odd while being written) so report() never prints a torn entry.
+struct Slot {
+    std::atomic<const void*> key;
+    std::atomic<std::uint32_t> sequence;
+    std::atomic<std::uint32_t> state;
+    std::atomic<const char*> typeName;
+    std::atomic<int> frameCount;
+    std::atomic<void*> frames[MAX_FRAMES];
+};
+
+// Zero-initialised static storage with trivial destructors, so objects
+// destroyed during static teardown can still unregister safely
+inline Slot* slots() {
+    static Slot table[CAPACITY];
+    return table;
+}
+
+inline std::atomic<std::size_t>& overflowCount() {
+    static std::atomic<std::size_t> count{0};
+    return count;
+}
+
+// Largest distance from its home slot any key was ever stored at. Lookups scan
+// only that window and don't rely on empty slots to stop, so a deleted slot
+// can be emptied right away instead of leaving a tombstone behind.
+inline std::atomic<std::size_t>& maxProbe() {
+    static std::atomic<std::size_t> probe{0};
+    return probe;
+}
+
+inline std::size_t slotIndex(const void* p) {
+    std::uintptr_t h = reinterpret_cast<std::uintptr_t>(p) >> 4;
+    h ^= h >> 17;
+    h *= 0x9E3779B97F4A7C15ull;
+    return static_cast<std::size_t>(h >> 32) % CAPACITY;
+}
+
+// Find the slot currently holding p within the probe window
+inline Slot* findSlot(const void* p) {
+    std::size_t start = slotIndex(p);
+    std::size_t window = maxProbe().load(std::memory_order_acquire);
+    for (std::size_t probe = 0; probe <= window; ++probe) {
+        Slot& slot = slots()[(start + probe) % CAPACITY];
+        if (slot.key.load(std::memory_order_acquire) == p) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+inline void writeMetadata(Slot& slot, SlotState state, const char* typeName, bool captureStack) {
+    slot.sequence.fetch_add(1, std::memory_order_acq_rel);
+    slot.state.store(state, std::memory_order_relaxed);
+    if (captureStack) {
+        void* frames[MAX_FRAMES];
+        int count = backtrace(frames, MAX_FRAMES);
+        for (int i = 0; i < count; ++i) {
+            slot.frames[i].store(frames[i], std::memory_order_relaxed);
+        }
+        slot.frameCount.store(count, std::memory_order_relaxed);
+        slot.typeName.store(typeName, std::memory_order_relaxed);
+    }
+    slot.sequence.fetch_add(1, std::memory_order_release);
+}
+
+// A UniquePtr took ownership of p (fresh object or re-adopted after release())
+inline void onAdopt(const void* p, const char* typeName) {
+    if (p == nullptr) {
+        return;
+    }
+    if (Slot* existing = findSlot(p)) {
+        writeMetadata(*existing, OWNED, typeName, true);
+        return;
+    }
+    std::size_t start = slotIndex(p);
+    for (std::size_t probe = 0; probe < CAPACITY; ++probe) {
+        Slot& slot = slots()[(start + probe) % CAPACITY];
+        if (slot.key.load(std::memory_order_relaxed) != nullptr) {
+            continue;
+        }
+        // Widen the window before p becomes visible, so any later lookup of p covers it
+        std::size_t window = maxProbe().load(std::memory_order_relaxed);
+        while (window < probe &&
+               !maxProbe().compare_exchange_weak(window, probe, std::memory_order_release)) {
+        }
+        const void* empty = nullptr;
+        if (slot.key.compare_exchange_strong(empty, p, std::memory_order_acq_rel)) {
+            writeMetadata(slot, OWNED, typeName, true);
+            return;
+        }
+    }
+    overflowCount().fetch_add(1, std::memory_order_relaxed);
+}
+
+// Ownership of p left UniquePtr through release()
+inline void onRelease(const void* p) {
+    if (Slot* slot = findSlot(p)) {
+        writeMetadata(*slot, RELEASED, nullptr, false);
+    }
+}
+
+// A UniquePtr is about to delete p
+inline void onDelete(const void* p) {
+    if (Slot* slot = findSlot(p)) {
+        slot->state.store(0, std::memory_order_relaxed);
+        slot->key.store(nullptr, std::memory_order_release);
+    }
+}
+
+// Print every outstanding object and the stack that handed it to UniquePtr.
+// Safe to call while other threads keep adopting and deleting objects.
+inline std::size_t report(int fd = STDERR_FILENO) {
+    std::size_t outstanding = 0;
+    for (std::size_t i = 0; i < CAPACITY; ++i) {
+        Slot& slot = slots()[i];
+        const void* key = slot.key.load(std::memory_order_acquire);
+        if (key == nullptr) {
+            continue;
+        }
+
+        std::uint32_t state;
+        const char* typeName;
+        int frameCount;
+        void* frames[MAX_FRAMES];
+        std::uint32_t before;
+        do {
+            before = slot.sequence.load(std::memory_order_acquire);
+            state = slot.state.load(std::memory_order_relaxed);
+            typeName = slot.typeName.load(std::memory_order_relaxed);
+            frameCount = slot.frameCount.load(std::memory_order_relaxed);
+            for (int f = 0; f < frameCount; ++f) {
+                frames[f] = slot.frames[f].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((before & 1) || before != slot.sequence.load(std::memory_order_relaxed));
+
+        if (state == 0 || slot.key.load(std::memory_order_acquire) != key) {
+            continue; // Deleted while we were reading
+        }
+        outstanding++;
+        dprintf(fd, "UniquePtr tracking: %s %s at %p, acquired at:\n",
+                state == RELEASED ? "released (unowned)" : "owned", typeName ? typeName : "?", key);
+        backtrace_symbols_fd(frames, frameCount, fd);
+    }
+    std::size_t overflow = overflowCount().load(std::memory_order_relaxed);
+    dprintf(fd, "UniquePtr tracking: %zu outstanding object(s)", outstanding);
+    if (overflow) {
+        dprintf(fd, ", %zu untracked (registry full)", overflow);
+    }
+    dprintf(fd, "\n");
+    return outstanding;
+}
+
+// Prints the report once static destruction begins
+struct ExitReporter {
+    ~ExitReporter() {
+        report();
+    }
+};
+
+inline ExitReporter exitReporter;
+
+#else
+
+// Release build: tracking hooks compile away entirely
+inline void onAdopt(const void*, const char*) {}
+inline void onRelease(const void*) {}
+inline void onDelete(const void*) {}
+inline std::size_t report(int = 2) {
+    return 0;
+}
+
+#endif
+
+template <typename T>
+const char* typeName() {
+#ifdef UNIQUE_PTR_TRACKING
+    return typeid(T).name();
+#else
+    return nullptr;
+#endif
+}
+
+} // namespace uniquePtrTracking
 
 // Implementation of std::unique_ptr
 
+template <typename T> class AtomicUniquePtr;
+template <typename T, std::size_t N> class InlineBox;
+
 template <typename T>
 class UniquePtr {
 private:
     T* ptr; // Raw pointer to manage
 
+    // Ownership moves into an AtomicUniquePtr slot or an InlineBox, which still
+    // own the object, so unlike release() the tracking hook does not fire
+    template <typename> friend class AtomicUniquePtr;
+    template <typename, std::size_t> friend class InlineBox;
+    T* handOff() {
+        T* oldPtr = ptr;
+        ptr = nullptr;
+        return oldPtr;
+    }
+
 public:
     // Constructor: Takes ownership of a raw pointer
-    explicit UniquePtr(T* p = nullptr) : ptr(p) {}
+    explicit UniquePtr(T* p = nullptr) : ptr(p) {
+        uniquePtrTracking::onAdopt(ptr, uniquePtrTracking::typeName<T>());
+    }
 
     // Destructor: Deletes the managed object
     ~UniquePtr() {
+        uniquePtrTracking::onDelete(ptr);
         delete ptr;
     }
 
@@ -31,6 +273,7 @@ public:
     // Move assignment operator: Transfers ownership
     UniquePtr& operator=(UniquePtr&& other) noexcept {
         if (this != &other) {
+            uniquePtrTracking::onDelete(ptr);
             delete ptr;        // Free the current resource
             ptr = other.ptr;   // Transfer ownership
             other.ptr = nullptr;
@@ -48,17 +291,25 @@ public:
         return *ptr;
     }
 
+    // Get the managed pointer without releasing ownership
+    T* get() const {
+        return ptr;
+    }
+
     // Release ownership of the managed object
     T* release() {
         T* oldPtr = ptr;
         ptr = nullptr;
+        uniquePtrTracking::onRelease(oldPtr);
         return oldPtr;
     }
 
     // Reset the managed object
     void reset(T* newPtr = nullptr) {
+        uniquePtrTracking::onDelete(ptr);
         delete ptr;
         ptr = newPtr;
+        uniquePtrTracking::onAdopt(ptr, uniquePtrTracking::typeName<T>());
     }
 
     // Check if the pointer is not null
@@ -67,6 +318,214 @@ public:
     }
 };
 
+#ifndef UNIQUE_PTR_TRACKING
+static_assert(sizeof(UniquePtr<int>) == sizeof(int*), "UniquePtr must stay pointer-sized");
+#endif
+
+// Single-slot, lock-free handoff of UniquePtr ownership between threads.
+// The slot owns whatever it holds; every operation moves ownership in or
+// out atomically, so an object is always owned by exactly one side.
+template <typename T>
+class AtomicUniquePtr {
+private:
+    std::atomic<T*> ptr; // Owned pointer, nullptr when the slot is empty
+
+    static_assert(std::atomic<T*>::is_always_lock_free,
+                  "AtomicUniquePtr requires lock-free pointer atomics");
+
+public:
+    // Constructor: Starts empty or takes ownership from a UniquePtr
+    AtomicUniquePtr() noexcept : ptr(nullptr) {}
+    explicit AtomicUniquePtr(UniquePtr<T> p) noexcept : ptr(p.handOff()) {}
+
+    // Destructor: Deletes whatever is still parked in the slot
+    ~AtomicUniquePtr() {
+        UniquePtr<T> owner(ptr.load(std::memory_order_acquire));
+    }
+
+    // The slot itself is shared by address, never copied or moved
+    AtomicUniquePtr(const AtomicUniquePtr&) = delete;
+    AtomicUniquePtr& operator=(const AtomicUniquePtr&) = delete;
+
+    // Store a new object and hand back the previous one.
+    // Release publishes the new object's contents to the next taker,
+    // acquire makes the previous object's contents visible to us.
+    UniquePtr<T> exchange(UniquePtr<T> desired) noexcept {
+        return UniquePtr<T>(ptr.exchange(desired.handOff(), std::memory_order_acq_rel));
+    }
+
+    // Take the current object, leaving the slot empty.
+    // An empty slot is detected with a plain load so idle polling does
+    // not keep the cache line in exclusive state.
+    UniquePtr<T> take() noexcept {
+        if (ptr.load(std::memory_order_relaxed) == nullptr) {
+            return UniquePtr<T>();
+        }
+        return UniquePtr<T>(ptr.exchange(nullptr, std::memory_order_acquire));
+    }
+
+    // Install desired if the slot still holds expected (compared by address).
+    // On success desired receives the previous object, so no ownership is
+    // lost; on failure expected is updated and desired is left untouched.
+    bool compare_exchange(T*& expected, UniquePtr<T>& desired) noexcept {
+        if (ptr.compare_exchange_strong(expected, desired.get(),
+                                        std::memory_order_acq_rel,
+                                        std::memory_order_acquire)) {
+            desired.handOff();
+            desired.reset(expected);
+            return true;
+        }
+        return false;
+    }
+
+    // Check if the slot currently holds an object (a snapshot only)
+    bool isValid() const {
+        return ptr.load(std::memory_order_acquire) != nullptr;
+    }
+};
+
+// Move-only owner like UniquePtr that keeps small objects inline.
+// Objects of up to N bytes (including derived types of T) are constructed
+// in the box itself; anything larger or over-aligned falls back to the heap.
+template <typename T, std::size_t N = 48>
+class InlineBox {
+private:
+    // Type-erased operations for the concrete type living in storage
+    struct InlineOps {
+        void (*destroy)(void* storage);
+        void (*relocate)(void* dst, void* src); // Move-construct into dst, destroy src
+    };
+
+    template <typename U>
+    static constexpr bool fitsInline =
+        sizeof(U) <= N && alignof(U) <= alignof(std::max_align_t) &&
+        std::is_nothrow_move_constructible<U>::value;
+
+    template <typename U>
+    static const InlineOps* opsFor() {
+        static const InlineOps ops = {
+            [](void* storage) { static_cast<U*>(storage)->~U(); },
+            [](void* dst, void* src) {
+                ::new (dst) U(std::move(*static_cast<U*>(src)));
+                static_cast<U*>(src)->~U();
+            }};
+        return &ops;
+    }
+
+    alignas(std::max_align_t) unsigned char storage[N];
+    T* ptr;               // Object pointer, into storage or the heap
+    const InlineOps* ops; // Non-null only when the object lives in storage
+
+    void destroy() {
+        if (ops) {
+            ops->destroy(storage);
+        } else {
+            UniquePtr<T> owner(ptr); // Delete through UniquePtr so ownership tracking sees it
+        }
+        ptr = nullptr;
+        ops = nullptr;
+    }
+
+    void takeFrom(InlineBox& other) noexcept {
+        if (other.ops) {
+            // Base-to-derived offset is fixed per type, so it survives relocation
+            std::ptrdiff_t offset = reinterpret_cast<unsigned char*>(other.ptr) - other.storage;
+            other.ops->relocate(storage, other.storage);
+            ptr = reinterpret_cast<T*>(storage + offset);
+        } else {
+            ptr = other.ptr;
+        }
+        ops = other.ops;
+        other.ptr = nullptr;
+        other.ops = nullptr;
+    }
+
+public:
+    // Constructor: Empty box, or adopts an already heap-allocated object
+    InlineBox() noexcept : ptr(nullptr), ops(nullptr) {}
+    explicit InlineBox(UniquePtr<T> p) noexcept : ptr(p.handOff()), ops(nullptr) {}
+
+    // Destructor: Destroys the contained object wherever it lives
+    ~InlineBox() {
+        destroy();
+    }
+
+    // Delete copy constructor and copy assignment to prevent copying
+    InlineBox(const InlineBox&) = delete;
+    InlineBox& operator=(const InlineBox&) = delete;
+
+    // Move constructor: Relocates inline objects, steals heap pointers
+    InlineBox(InlineBox&& other) noexcept : ptr(nullptr), ops(nullptr) {
+        takeFrom(other);
+    }
+
+    // Move assignment operator: Destroys current object, then transfers
+    InlineBox& operator=(InlineBox&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            takeFrom(other);
+        }
+        return *this;
+    }
+
+    // Construct a U (T or a type derived from T) in place, replacing any current object
+    template <typename U = T, typename... Args>
+    U& emplace(Args&&... args) {
+        static_assert(std::is_base_of<T, U>::value || std::is_same<T, U>::value,
+                      "InlineBox can only hold T or types derived from T");
+        destroy();
+        U* obj;
+        if constexpr (fitsInline<U>) {
+            obj = ::new (static_cast<void*>(storage)) U(std::forward<Args>(args)...);
+            ops = opsFor<U>();
+        } else {
+            static_assert(std::has_virtual_destructor<T>::value || std::is_same<T, U>::value,
+                          "Heap fallback for derived types requires a virtual destructor");
+            obj = new U(std::forward<Args>(args)...);
+        }
+        ptr = obj;
+        return *obj;
+    }
+
+    // Factory: Builds a box holding a freshly constructed U
+    template <typename U = T, typename... Args>
+    static InlineBox make(Args&&... args) {
+        InlineBox box;
+        box.template emplace<U>(std::forward<Args>(args)...);
+        return box;
+    }
+
+    // Access the underlying object
+    T* operator->() const {
+        return ptr;
+    }
+
+    // Dereference the underlying object
+    T& operator*() const {
+        return *ptr;
+    }
+
+    // Get the managed pointer without releasing ownership
+    T* get() const {
+        return ptr;
+    }
+
+    // Destroy the contained object, leaving the box empty
+    void reset() {
+        destroy();
+    }
+
+    // Check if the box holds an object
+    bool isValid() const {
+        return ptr != nullptr;
+    }
+
+    // Check if the object is stored inline rather than on the heap
+    bool isInline() const {
+        return ops != nullptr;
+    }
+};
+
 
 int main() {
     //Examples
@@ -103,7 +562,7 @@ int main() {
 
     int* rawPtr = uptr2.release(); // Release ownership
     std::cout << "Raw pointer value: " << *rawPtr << std::endl;
-    delete rawPtr; // Manually delete the released pointer
+    UniquePtr<int> readopted(rawPtr); // Hand the released pointer back instead of deleting it manually
 
     UniquePtr<int> uptr3;
     uptr3 = std::move(uptr2); // Move assignment
@@ -115,5 +574,47 @@ int main() {
         std::cout << "Value in uptr3: " << *uptr3 << std::endl;
     }
 
+    // Handing ownership between threads through a single-slot mailbox
+    AtomicUniquePtr<int> mailbox;
+    std::thread producer([&mailbox] {
+        UniquePtr<int> msg(new int(7));
+        int* expected = nullptr;
+        while (!mailbox.compare_exchange(expected, msg)) {
+            expected = nullptr; // Wait until the consumer has drained the slot
+        }
+    });
+    UniquePtr<int> received;
+    while (!received.isValid()) {
+        received = mailbox.take();
+    }
+    producer.join();
+    std::cout << "Received through mailbox: " << *received << std::endl;
+
+    // Small payloads live inside the box, large ones fall back to the heap
+    struct Payload {
+        virtual ~Payload() = default;
+        virtual std::size_t size() const = 0;
+    };
+    struct SmallPayload : Payload {
+        char bytes[16] = {};
+        std::size_t size() const override { return sizeof(bytes); }
+    };
+    struct LargePayload : Payload {
+        char bytes[256] = {};
+        std::size_t size() const override { return sizeof(bytes); }
+    };
+
+    alloc_tracking::AllocationCounter boxAllocations;
+    auto small = InlineBox<Payload>::make<SmallPayload>();
+    InlineBox<Payload> moved = std::move(small);
+    if (alloc_tracking::enabled) {
+        std::cout << "Allocations for small payload: " << boxAllocations.allocations() << std::endl;
+    }
+    auto large = InlineBox<Payload>::make<LargePayload>();
+    std::cout << "Small payload (" << moved->size() << " bytes) inline: "
+              << std::boolalpha << moved.isInline() << std::endl;
+    std::cout << "Large payload (" << large->size() << " bytes) inline: "
+              << large.isInline() << std::endl;
+
     return 0;
 }
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// How a consumer (or a producer waiting for space) waits for progress
+enum class WaitKind : uint8_t {
+    BusySpin,  // Spin with a pause hint; lowest latency, burns a core
+    SpinYield, // Spin for spinLimit rounds, then yield the CPU between checks
+    Blocking,  // Sleep on a futex until notified; no CPU while idle
+    Adaptive,  // Spin, then yield for yieldLimit rounds, then block
+};
+
+// Per-consumer wait configuration; cpu >= 0 pins the consumer's thread to that CPU
+struct WaitStrategy {
+    WaitKind kind = WaitKind::SpinYield;
+    unsigned spinLimit = 100;
+    unsigned yieldLimit = 100;
+    int cpu = -1;
+};
+
+// Tells the core we are spinning (frees pipeline resources for the sibling hyperthread)
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Pins the calling thread to a CPU; a negative CPU leaves scheduling alone
+inline bool pin_current_thread(int cpu) {
+#ifdef __linux__
+    if (cpu < 0) {
+        return true;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return cpu < 0;
+#endif
+}
+
+// Wake-up point shared by everyone waiting on one queue or ring.
+// Whoever makes progress calls notify(); it costs a fence and an increment, and a futex wake
+// only when some waiter is actually asleep. Waiters re-check their condition after announcing
+// themselves and sleep only if the epoch has not moved since, so a notify can't be lost.
+class WakeupChannel {
+private:
+    std::atomic<uint32_t> epoch_{0};
+    std::atomic<uint32_t> sleepers_{0};
+
+    template <typename Ready> void block(Ready& ready) {
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        uint32_t epoch = epoch_.load(std::memory_order_seq_cst);
+        if (!ready()) {
+#ifdef __linux__
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAIT_PRIVATE, epoch, nullptr, nullptr, 0);
+#else
+            while (epoch_.load(std::memory_order_acquire) == epoch && !ready()) {
+                std::this_thread::yield();
+            }
+#endif
+        }
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+public:
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        epoch_.fetch_add(1, std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_seq_cst) != 0) {
+#ifdef __linux__
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#endif
+        }
+    }
+
+    // Returns once ready() is true, waiting as the strategy says
+    template <typename Ready> void wait(const WaitStrategy& strategy, Ready&& ready) {
+        unsigned spins = 0;
+        unsigned yields = 0;
+        while (!ready()) {
+            switch (strategy.kind) {
+            case WaitKind::BusySpin:
+                cpu_relax();
+                break;
+            case WaitKind::SpinYield:
+                if (spins < strategy.spinLimit) {
+                    ++spins;
+                    cpu_relax();
+                } else {
+                    std::this_thread::yield();
+                }
+                break;
+            case WaitKind::Blocking:
+                block(ready);
+                break;
+            case WaitKind::Adaptive:
+                if (spins < strategy.spinLimit) {
+                    ++spins;
+                    cpu_relax();
+                } else if (yields < strategy.yieldLimit) {
+                    ++yields;
+                    std::this_thread::yield();
+                } else {
+                    block(ready);
+                }
+                break;
+            }
+        }
+    }
+};